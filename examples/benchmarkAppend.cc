@@ -0,0 +1,141 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * Time building a single array property one value at a time.
+ *
+ * Each way of appending is timed for 10^5 and 10^6 values.  Appending takes
+ * amortized constant time, so the time per value should not grow with the
+ * number of values; the program fails if it grows by more than GROWTH_LIMIT,
+ * which would indicate quadratic behavior.  Times are reported in
+ * nanoseconds per appended value.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lsst/daf/base/PropertyList.h"
+#include "lsst/daf/base/PropertySet.h"
+
+namespace dafBase = lsst::daf::base;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Largest acceptable ratio of the time per value at 10^6 values to that at 10^5
+double const GROWTH_LIMIT = 3.0;
+
+// Append n values, one at a time, to a property of an empty ps and return its name
+typedef std::function<std::string(dafBase::PropertySet& ps, std::size_t n)> Appender;
+
+double nsPerValue(Appender const& append, dafBase::PropertySet& ps, std::size_t n) {
+    auto const start = Clock::now();
+    std::string const name = append(ps, n);
+    auto const elapsed = Clock::now() - start;
+    if (ps.valueCount(name) != n) {
+        throw std::runtime_error("Wrong number of values appended");
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / n;
+}
+
+}  // namespace
+
+int main() {
+    struct Case {
+        std::string name;
+        bool list;
+        Appender append;
+    };
+    std::vector<Case> const cases = {
+            {"add(int)", false,
+             [](dafBase::PropertySet& ps, std::size_t n) {
+                 for (std::size_t i = 0; i < n; ++i) ps.add("stat", static_cast<int>(i));
+                 return "stat";
+             }},
+            {"add(vector<int>)", false,
+             [](dafBase::PropertySet& ps, std::size_t n) {
+                 for (std::size_t i = 0; i < n; ++i) ps.add("stat", std::vector<int>(1, i));
+                 return "stat";
+             }},
+            {"add(string)", false,
+             [](dafBase::PropertySet& ps, std::size_t n) {
+                 for (std::size_t i = 0; i < n; ++i) ps.add("stat", std::string("visit"));
+                 return "stat";
+             }},
+            {"add(int) nested", false,
+             [](dafBase::PropertySet& ps, std::size_t n) {
+                 for (std::size_t i = 0; i < n; ++i) ps.add("a.b.stat", static_cast<int>(i));
+                 return "a.b.stat";
+             }},
+            {"reserve+add(int)", false,
+             [](dafBase::PropertySet& ps, std::size_t n) {
+                 ps.set("stat", 0);
+                 ps.reserve("stat", n);
+                 for (std::size_t i = 1; i < n; ++i) ps.add("stat", static_cast<int>(i));
+                 return "stat";
+             }},
+            {"combine", false,
+             [](dafBase::PropertySet& ps, std::size_t n) {
+                 dafBase::PropertySet visit;
+                 visit.set("stat", 1);
+                 for (std::size_t i = 0; i < n; ++i) ps.combine(visit);
+                 return "stat";
+             }},
+            {"PropertyList add", true, [](dafBase::PropertySet& ps, std::size_t n) {
+                 auto& pl = dynamic_cast<dafBase::PropertyList&>(ps);
+                 for (std::size_t i = 0; i < n; ++i) pl.add("stat", static_cast<int>(i));
+                 return "stat";
+             }}};
+
+    bool ok = true;
+    std::cout << "ns per appended value" << std::endl;
+    std::cout << std::setw(20) << "append" << std::setw(10) << "10^5" << std::setw(10) << "10^6"
+              << std::endl;
+    for (auto const& c : cases) {
+        double perValue[2];
+        std::size_t const counts[2] = {100000, 1000000};
+        for (int k = 0; k < 2; ++k) {
+            std::shared_ptr<dafBase::PropertySet> ps;
+            if (c.list) {
+                ps = std::make_shared<dafBase::PropertyList>();
+            } else {
+                ps = std::make_shared<dafBase::PropertySet>();
+            }
+            perValue[k] = nsPerValue(c.append, *ps, counts[k]);
+        }
+        bool const linear = perValue[1] < GROWTH_LIMIT * perValue[0];
+        ok = ok && linear;
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << std::setw(20) << c.name << std::setw(10) << perValue[0] << std::setw(10) << perValue[1]
+                  << (linear ? "" : "  superlinear") << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * Compare ConcurrentPropertySet with a PropertySet behind a single mutex.
+ *
+ * Each of 1 to 64 threads performs the same number of operations on its
+ * own hierarchical names and on names shared by all threads; one operation
+ * in WRITE_EVERY is a set or add and the rest are gets.  Throughput is
+ * reported in millions of operations per second, summed over all threads.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lsst/daf/base/ConcurrentPropertySet.h"
+#include "lsst/daf/base/PropertySet.h"
+
+namespace dafBase = lsst::daf::base;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Operations performed by each thread
+std::size_t const OPERATIONS = 200000;
+
+// One operation in this many modifies the set
+std::size_t const WRITE_EVERY = 10;
+
+// Names each thread cycles through
+std::size_t const NAMES = 16;
+
+// Keeps the reads from being optimized away
+long volatile sink;
+
+// The baseline: every access takes the same lock
+class LockedPropertySet {
+public:
+    template <typename T>
+    T get(std::string const& name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _set.get<T>(name);
+    }
+
+    template <typename T>
+    void set(std::string const& name, T const& value) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _set.set(name, value);
+    }
+
+    template <typename T>
+    void add(std::string const& name, T const& value) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _set.add(name, value);
+    }
+
+private:
+    std::mutex _mutex;
+    dafBase::PropertySet _set;
+};
+
+std::vector<std::string> makeNames(std::string const& prefix) {
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < NAMES; ++i) {
+        names.push_back(prefix + ".group" + std::to_string(i % 4) + ".value" + std::to_string(i));
+    }
+    return names;
+}
+
+template <typename Set>
+void work(Set& set, int thread) {
+    std::vector<std::string> const own = makeNames("thread" + std::to_string(thread));
+    std::vector<std::string> const shared = makeNames("shared");
+    for (auto const& name : own) set.set(name, 0L);
+    long sum = 0;
+    for (std::size_t i = 0; i < OPERATIONS; ++i) {
+        // Alternate between private and shared names
+        std::string const& name = (i & 1) ? shared[i % NAMES] : own[i % NAMES];
+        if (i % WRITE_EVERY == 0) {
+            set.set(name, static_cast<long>(i));
+        } else {
+            try {
+                sum += set.template get<long>(name);
+            } catch (...) {
+                // Shared names may not have been set yet
+            }
+        }
+    }
+    sink = sum;
+}
+
+template <typename Set>
+double run(Set& set, int nThreads) {
+    std::vector<std::thread> threads;
+    auto const start = Clock::now();
+    for (int t = 0; t < nThreads; ++t) {
+        threads.emplace_back([&set, t]() { work(set, t); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return nThreads * OPERATIONS / seconds / 1e6;
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Million operations per second (" << std::thread::hardware_concurrency()
+              << " hardware threads)" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "mutex" << std::setw(12) << "sharded"
+              << std::endl;
+    for (int nThreads = 1; nThreads <= 64; nThreads *= 2) {
+        LockedPropertySet locked;
+        dafBase::ConcurrentPropertySet sharded;
+        double const lockedRate = run(locked, nThreads);
+        double const shardedRate = run(sharded, nThreads);
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << std::setw(8) << nThreads << std::setw(12) << lockedRate << std::setw(12) << shardedRate
+                  << std::endl;
+    }
+    return 0;
+}
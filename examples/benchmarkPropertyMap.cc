@@ -0,0 +1,139 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * Compare the map used to hold PropertySet entries with std::unordered_map.
+ *
+ * For each map size, time inserting all keys, looking up every key (hits),
+ * looking up absent keys (misses) and copying the map.  Times are reported
+ * in nanoseconds per operation.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lsst/daf/base/detail/FlatMap.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Repeat each measurement over about this many operations to smooth out timer noise
+std::size_t const OPERATIONS = 2000000;
+
+// Keeps the work from being optimized away
+std::size_t volatile sink;
+
+struct Result {
+    double insert = 0;
+    double hit = 0;
+    double miss = 0;
+    double copy = 0;
+};
+
+double nsPerOp(Clock::duration elapsed, std::size_t ops) {
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+}
+
+template <typename Map>
+Result run(std::vector<std::string> const& keys, std::vector<std::string> const& absent) {
+    Result result;
+    std::size_t const repeats = std::max<std::size_t>(1, OPERATIONS / keys.size());
+    std::size_t found = 0;
+
+    Map map;
+    auto start = Clock::now();
+    for (std::size_t r = 0; r < repeats; ++r) {
+        Map m;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            m.emplace(keys[i], i);
+        }
+        found += m.size();
+        if (r == 0) map = m;
+    }
+    result.insert = nsPerOp(Clock::now() - start, repeats * keys.size());
+
+    start = Clock::now();
+    for (std::size_t r = 0; r < repeats; ++r) {
+        for (auto const& key : keys) {
+            found += map.find(key) != map.end();
+        }
+    }
+    result.hit = nsPerOp(Clock::now() - start, repeats * keys.size());
+
+    start = Clock::now();
+    for (std::size_t r = 0; r < repeats; ++r) {
+        for (auto const& key : absent) {
+            found += map.find(key) != map.end();
+        }
+    }
+    result.miss = nsPerOp(Clock::now() - start, repeats * absent.size());
+
+    start = Clock::now();
+    for (std::size_t r = 0; r < repeats; ++r) {
+        Map m(map);
+        found += m.size();
+    }
+    result.copy = nsPerOp(Clock::now() - start, repeats * keys.size());
+
+    sink = found;
+    return result;
+}
+
+// Keys shaped like FITS-derived metadata names
+std::vector<std::string> makeKeys(std::size_t n, std::string const& prefix) {
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        keys.push_back(prefix + std::to_string(i));
+    }
+    return keys;
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "ns per operation" << std::endl;
+    std::cout << std::setw(8) << "keys" << std::setw(16) << "map" << std::setw(10) << "insert"
+              << std::setw(10) << "hit" << std::setw(10) << "miss" << std::setw(10) << "copy" << std::endl;
+    for (std::size_t n : {10, 100, 1000, 100000}) {
+        std::vector<std::string> const keys = makeKeys(n, "HIERARCH KEY");
+        std::vector<std::string> const absent = makeKeys(n, "HIERARCH NOKEY");
+        auto const flat = run<lsst::daf::base::detail::FlatMap<std::size_t>>(keys, absent);
+        auto const unordered = run<std::unordered_map<std::string, std::size_t>>(keys, absent);
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << std::setw(8) << n << std::setw(16) << "FlatMap" << std::setw(10) << flat.insert
+                  << std::setw(10) << flat.hit << std::setw(10) << flat.miss << std::setw(10) << flat.copy
+                  << std::endl;
+        std::cout << std::setw(8) << n << std::setw(16) << "unordered_map" << std::setw(10) << unordered.insert
+                  << std::setw(10) << unordered.hit << std::setw(10) << unordered.miss << std::setw(10) << unordered.copy
+                  << std::endl;
+    }
+    return 0;
+}
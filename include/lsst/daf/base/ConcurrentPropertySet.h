@@ -0,0 +1,207 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_CONCURRENTPROPERTYSET_H
+#define LSST_DAF_BASE_CONCURRENTPROPERTYSET_H
+
+/** @class lsst::daf::base::ConcurrentPropertySet
+ * @brief A PropertySet that may be read and modified from many threads at once.
+ *
+ * Properties are divided among a fixed number of shards by the first
+ * component of their names, and each shard is a PropertySet guarded by its
+ * own reader-writer lock.  Readers of a shard proceed in parallel, and
+ * writers only exclude other threads using the same shard.  Everything under
+ * a hierarchical name "a.b.c" lives in the shard of "a", so a write creates
+ * any missing intermediate PropertySets atomically.
+ *
+ * PropertySets are never shared with the caller: those passed to set or add
+ * are deep-copied in, and those returned by get are deep copies, so nested
+ * sets cannot be modified without the lock.
+ *
+ * @ingroup daf_base
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lsst/base.h"
+#include "lsst/daf/base/PropertySet.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+class LSST_EXPORT ConcurrentPropertySet {
+public:
+    /// Number of shards used by default
+    static constexpr std::size_t DEFAULT_SHARDS = 64;
+
+    /**
+     * Construct an empty ConcurrentPropertySet.
+     *
+     * @param[in] shards Number of independently locked shards; more shards
+     *                   let more writers proceed at once.
+     * @throws InvalidParameterError shards is zero.
+     */
+    explicit ConcurrentPropertySet(std::size_t shards = DEFAULT_SHARDS);
+
+    ~ConcurrentPropertySet() noexcept;
+
+    // No copying or moving
+    ConcurrentPropertySet(ConcurrentPropertySet const&) = delete;
+    ConcurrentPropertySet& operator=(ConcurrentPropertySet const&) = delete;
+
+    /// Number of shards
+    std::size_t getShardCount() const noexcept { return _shardCount; }
+
+    /**
+     * Get the last value for a property name (possibly hierarchical).
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return Last value set or added; a deep copy for PropertySets.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    T get(std::string_view name) const;
+
+    /**
+     * Get the last value for a property name (possibly hierarchical),
+     * returning the default if it does not exist.
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @param[in] defaultValue Default value to return if property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    T get(std::string_view name, T const& defaultValue) const;
+
+    /**
+     * Get the vector of values for a property name (possibly hierarchical).
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    std::vector<T> getArray(std::string_view name) const;
+
+    /**
+     * Determine if a name (possibly hierarchical) exists.
+     *
+     * @param[in] name Property name to find, possibly hierarchical.
+     */
+    bool exists(std::string_view name) const;
+
+    /**
+     * Get the names, optionally including those in subproperties.
+     *
+     * All shards are locked for reading while the names are collected, so
+     * the result is a consistent snapshot.
+     *
+     * @param[in] topLevelOnly If true (default) omit names from subproperties.
+     */
+    std::vector<std::string> names(bool topLevelOnly = true) const;
+
+    /**
+     * Copy the contents into an ordinary PropertySet, as a consistent snapshot.
+     */
+    std::shared_ptr<PropertySet> deepCopy() const;
+
+    /**
+     * Replace all values for a property name (possibly hierarchical) with a
+     * new scalar value, creating any missing intermediate PropertySets.
+     *
+     * @param[in] name Property name to set, possibly hierarchical.
+     * @param[in] value Value to set; PropertySets are deep-copied.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void set(std::string const& name, T const& value);
+
+    /**
+     * Replace all values for a property name (possibly hierarchical) with a
+     * vector of new values.
+     *
+     * @param[in] name Property name to set, possibly hierarchical.
+     * @param[in] value Vector of values to set; PropertySets are deep-copied.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void set(std::string const& name, std::vector<T> const& value);
+
+    /// Replace all values for a property name with a string value
+    void set(std::string const& name, char const* value);
+
+    /**
+     * Append a single value to the vector of values for a property name
+     * (possibly hierarchical), setting it if it does not exist.
+     *
+     * @param[in] name Property name to append to, possibly hierarchical.
+     * @param[in] value Value to append; PropertySets are deep-copied.
+     * @throws TypeError Type does not match existing values.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void add(std::string const& name, T const& value);
+
+    /**
+     * Append a vector of values to the vector of values for a property name
+     * (possibly hierarchical), setting it if it does not exist.
+     *
+     * @param[in] name Property name to append to, possibly hierarchical.
+     * @param[in] value Vector of values to append; PropertySets are deep-copied.
+     * @throws TypeError Type does not match existing values.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void add(std::string const& name, std::vector<T> const& value);
+
+    /// Append a string value to the values for a property name
+    void add(std::string const& name, char const* value);
+
+    /**
+     * Remove all values for a property name (possibly hierarchical).  Does
+     * nothing if the property does not exist.
+     *
+     * @param[in] name Property name to remove, possibly hierarchical.
+     */
+    void remove(std::string const& name);
+
+private:
+    struct Shard;
+
+    Shard& _shardFor(std::string_view name) const;
+
+    std::unique_ptr<Shard[]> _shards;
+    std::size_t _shardCount;
+};
+
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_CONCURRENTPROPERTYSET_H
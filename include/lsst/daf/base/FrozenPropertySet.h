@@ -0,0 +1,216 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_FROZENPROPERTYSET_H
+#define LSST_DAF_BASE_FROZENPROPERTYSET_H
+
+/** @class lsst::daf::base::FrozenPropertySet
+ * @brief An immutable snapshot of a PropertySet or PropertyList.
+ *
+ * Made by PropertySet::freeze.  Every fully qualified name ("a", "a.b",
+ * "a.b.c") is indexed by a minimal perfect hash, so a lookup at any depth
+ * hashes the name once and examines a single slot.  Nothing can modify the
+ * snapshot, so it may be read from any number of threads without locking,
+ * and deepCopy merely shares it.
+ *
+ * PropertySets are never handed out: get and getArray return deep copies
+ * of nested sets, and thaw returns a modifiable deep copy of the whole.
+ *
+ * @ingroup daf_base
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+#include "lsst/base.h"
+#include "lsst/daf/base/PropertySet.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+class PropertyList;
+
+class LSST_EXPORT FrozenPropertySet : public std::enable_shared_from_this<FrozenPropertySet> {
+public:
+    ~FrozenPropertySet() noexcept;
+
+    // No copying; share the pointer instead
+    FrozenPropertySet(FrozenPropertySet const&) = delete;
+    FrozenPropertySet& operator=(FrozenPropertySet const&) = delete;
+
+    /// A snapshot is immutable, so its deep copy is itself
+    std::shared_ptr<FrozenPropertySet const> deepCopy() const { return shared_from_this(); }
+
+    /// Make a modifiable deep copy; a PropertyList if the snapshot was made from one
+    std::shared_ptr<PropertySet> thaw() const;
+
+    /// Whether the snapshot was made from a PropertyList
+    bool isPropertyList() const noexcept;
+
+    /**
+     * Get the number of names, optionally including those in subproperties.
+     *
+     * @param[in] topLevelOnly If true (default) omit names from subproperties.
+     */
+    std::size_t nameCount(bool topLevelOnly = true) const;
+
+    /// Get the names, optionally including those in subproperties; see PropertySet::names
+    std::vector<std::string> names(bool topLevelOnly = true) const;
+
+    /// Get the names of non-PropertySet values; see PropertySet::paramNames
+    std::vector<std::string> paramNames(bool topLevelOnly = true) const;
+
+    /// Get the names of subproperties; see PropertySet::propertySetNames
+    std::vector<std::string> propertySetNames(bool topLevelOnly = true) const;
+
+    /// Determine if a name (possibly hierarchical) exists
+    bool exists(std::string_view name) const noexcept { return _lookup(name) != nullptr; }
+
+    /// Determine if a name (possibly hierarchical) has multiple values
+    bool isArray(std::string_view name) const noexcept;
+
+    /// Determine if a name (possibly hierarchical) is a subproperty
+    bool isPropertySetPtr(std::string_view name) const noexcept;
+
+    /// Number of values for a name (possibly hierarchical), or 0 if it does not exist
+    std::size_t valueCount(std::string_view name) const noexcept;
+
+    /**
+     * Get the type of a name (possibly hierarchical).
+     *
+     * @throws NotFoundError Property does not exist.
+     */
+    std::type_info const& typeOf(std::string_view name) const;
+
+    /**
+     * Get the type tag of a name (possibly hierarchical).
+     *
+     * @throws NotFoundError Property does not exist.
+     */
+    PropertySet::Type typeTag(std::string_view name) const;
+
+    /**
+     * Get the last value for a property name (possibly hierarchical).
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return Last value; a deep copy for PropertySets.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    T get(std::string_view name) const;
+
+    /**
+     * Get the last value for a property name (possibly hierarchical),
+     * returning the default if it does not exist.
+     *
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    T get(std::string_view name, T const& defaultValue) const;
+
+    /**
+     * Get the vector of values for a property name (possibly hierarchical).
+     *
+     * @return Values; deep copies for PropertySets.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    std::vector<T> getArray(std::string_view name) const;
+
+    /**
+     * View the values of a property name (possibly hierarchical) in place.
+     * Views remain valid for the lifetime of the snapshot.  Not available
+     * for PropertySets, which are only handed out as copies.
+     *
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    PropertySet::ArrayView<T> getArrayView(std::string_view name) const;
+
+    /**
+     * Get the names in the order they were added to the PropertyList.
+     *
+     * @throws LogicError The snapshot was not made from a PropertyList.
+     */
+    std::vector<std::string> getOrderedNames() const;
+
+    /**
+     * Get the comment for a name.
+     *
+     * @throws LogicError The snapshot was not made from a PropertyList.
+     * @throws NotFoundError Property does not exist.
+     */
+    std::string const& getComment(std::string const& name) const;
+
+    /// Generate a string representation; see PropertySet::toString
+    std::string toString(bool topLevelOnly = false, std::string const& indent = "") const;
+
+private:
+    friend class PropertySet;
+
+    typedef PropertySet::Values Values;
+
+    // One fully qualified name, at the index given by the perfect hash
+    struct Slot {
+        std::size_t hash;
+        Values const* values;     // Owned by _tree
+        std::uint32_t nameBegin;  // In _names
+        std::uint32_t nameSize;
+    };
+
+    /*
+     * Index a PropertySet that nothing else refers to.
+     *
+     * @param[in] tree PropertySet to take over.
+     */
+    explicit FrozenPropertySet(std::shared_ptr<PropertySet const> tree);
+
+    // The values for a name, or null if it does not exist
+    Values const* _lookup(std::string_view name) const noexcept;
+
+    // The values for a name; throws NotFoundError if it does not exist
+    Values const& _at(std::string_view name) const;
+
+    // The PropertyList the snapshot was made from; throws LogicError if it was not
+    PropertyList const& _list() const;
+
+    std::shared_ptr<PropertySet const> _tree;
+    std::string _names;                 // All fully qualified names, concatenated
+    std::vector<Slot> _slots;           // One per name, placed by the perfect hash
+    std::vector<std::uint32_t> _seeds;  // Per-bucket seeds of the perfect hash
+};
+
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_FROZENPROPERTYSET_H
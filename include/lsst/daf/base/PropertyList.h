@@ -46,13 +46,11 @@
 
 #include <list>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <typeinfo>
-#include <unordered_map>
 #include <vector>
 
-#include "boost/any.hpp"
-
 #include "lsst/base.h"
 #include "lsst/daf/base/PropertySet.h"
 
@@ -74,14 +72,31 @@ public:
     /// Construct an empty PropertyList
     PropertyList();
 
+    /**
+     * Construct an empty PropertyList whose storage comes from a memory resource.
+     *
+     * The names, values, and comments are allocated from resource as for
+     * PropertySet(std::pmr::memory_resource*, bool); resource must outlive
+     * the PropertyList.
+     *
+     * @param[in] resource Memory resource to allocate from.
+     */
+    explicit PropertyList(std::pmr::memory_resource* resource);
+
     /// Destructor
     virtual ~PropertyList() noexcept;
 
+    /// Move constructor and assignment; the moved-from PropertyList is left empty
+    PropertyList(PropertyList&& other) noexcept;
+    PropertyList& operator=(PropertyList&& other) noexcept;
+
     // Accessors
 
     /**
      * Make a deep copy of the PropertyList and all of its contents.
      *
+     * The copy allocates from the same memory resource as the original.
+     *
      * @return PropertyList pointing to the new copy.
      */
     virtual std::shared_ptr<PropertySet> deepCopy() const;
@@ -99,7 +114,7 @@ public:
      * @throws TypeError Value does not match desired type.
      */
     template <typename T>
-    T get(std::string const& name) const;
+    T get(std::string_view name) const;
 
     // I can't make copydoc work for this so...
     /**
@@ -115,11 +130,17 @@ public:
      * @throws TypeError Value does not match desired type.
      */
     template <typename T>
-    T get(std::string const& name, T const& defaultValue) const;
+    T get(std::string_view name, T const& defaultValue) const;
 
     /// @copydoc PropertySet::getArray()
     template <typename T>
-    std::vector<T> getArray(std::string const& name) const;
+    std::vector<T> getArray(std::string_view name) const;
+
+    /// @copydoc PropertySet::get(Key<T> const&) const
+    template <typename T>
+    T get(Key<T> const& key) const {
+        return PropertySet::get(key);
+    }
 
     /**
      * Get the comment for a string property name (possibly hierarchical).
@@ -139,8 +160,20 @@ public:
     /// End iterator over the list of property names, in the order they were added
     std::list<std::string>::const_iterator end() const;
 
-    /// @copydoc PropertySet::toString()
-    virtual std::string toString(bool topLevelOnly = false, std::string const& indent = "") const;
+    using PropertySet::fingerprint;
+
+    /**
+     * A fingerprint of the contents that optionally also covers the comments
+     * and the order of the names.
+     *
+     * With neither, it is the same as fingerprint().  Unlike the values, the
+     * comments and order are hashed on each call, in time linear in the
+     * number of names.
+     *
+     * @param[in] withComments Whether the comments contribute.
+     * @param[in] withOrder Whether the order of the names contributes.
+     */
+    std::uint64_t fingerprint(bool withComments, bool withOrder = false) const;
 
     // Modifiers
 
@@ -166,9 +199,27 @@ public:
     template <typename T>
     void set(std::string const& name, std::vector<T> const& value);
 
+    /// @copydoc PropertySet::set(std::string const&, std::vector<T>&&)
+    template <typename T>
+    void set(std::string const& name, std::vector<T>&& value);
+
+    /// @copydoc PropertySet::set(std::string const&, std::string&&)
+    void set(std::string const& name, std::string&& value);
+
     /// @copydoc PropertySet::set(std::string const &, char const*)
     void set(std::string const& name, char const* value);
 
+    /// @copydoc PropertySet::set(Key<T> const&, typename Key<T>::Value const&)
+    template <typename T>
+    void set(Key<T> const& key, typename Key<T>::Value const& value) {
+        PropertySet::set(key, value);
+    }
+
+    /// Replace all values for a precompiled property name with a new PropertySet; see above
+    void set(Key<std::shared_ptr<PropertySet>> const& key, std::shared_ptr<PropertySet> const& value) {
+        set(key.getName(), value);
+    }
+
     /// @copydoc PropertySet::add(std::string const&, T const&)
     template <typename T>
     void add(std::string const& name, T const& value);
@@ -177,6 +228,13 @@ public:
     template <typename T>
     void add(std::string const& name, std::vector<T> const& value);
 
+    /// @copydoc PropertySet::add(std::string const&, std::vector<T>&&)
+    template <typename T>
+    void add(std::string const& name, std::vector<T>&& value);
+
+    /// @copydoc PropertySet::add(std::string const&, std::string&&)
+    void add(std::string const& name, std::string&& value);
+
     /// @copydoc PropertySet::add(std::string const&, char const*)
     void add(std::string const& name, char const* value);
 
@@ -212,6 +270,29 @@ public:
      */
     void set(std::string const& name, char const* value, std::string const& comment);
 
+    /**
+     * Version of set vector value that accepts a comment and moves the
+     * values out of the vector.
+     *
+     * @param[in] name Property name to set, possibly hierarchical.
+     * @param[in] value Vector value to set; left in a valid but unspecified state.
+     * @param[in] comment Comment to set.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void set(std::string const& name, std::vector<T>&& value, std::string const& comment);
+
+    /**
+     * Version of set string value that accepts a comment and moves the
+     * string instead of copying it.
+     *
+     * @param[in] name Property name to set, possibly hierarchical.
+     * @param[in] value String value to set; left in a valid but unspecified state.
+     * @param[in] comment Comment to set.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    void set(std::string const& name, std::string&& value, std::string const& comment);
+
     /**
      * Version of add scalar value that accepts a comment.
      *
@@ -244,6 +325,29 @@ public:
      */
     void add(std::string const& name, char const* value, std::string const& comment);
 
+    /**
+     * Version of add vector value that accepts a comment and moves the
+     * values out of the vector.
+     *
+     * @param[in] name Property name to append to, possibly hierarchical.
+     * @param[in] value Vector value to add; left in a valid but unspecified state.
+     * @param[in] comment Comment to set.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void add(std::string const& name, std::vector<T>&& value, std::string const& comment);
+
+    /**
+     * Version of add string value that accepts a comment and moves the
+     * string instead of copying it.
+     *
+     * @param[in] name Property name to append to, possibly hierarchical.
+     * @param[in] value String value to add; left in a valid but unspecified state.
+     * @param[in] comment Comment to set.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    void add(std::string const& name, std::string&& value, std::string const& comment);
+
     /// @copydoc PropertyList::set(std::string const&, T const&, std::string const&)
     template <typename T>
     void set(std::string const& name, T const& value, char const* comment) {
@@ -261,6 +365,17 @@ public:
         set(name, value, std::string(comment));
     }
 
+    /// @copydoc PropertyList::set(std::string const&, std::vector<T>&&, std::string const&)
+    template <typename T>
+    void set(std::string const& name, std::vector<T>&& value, char const* comment) {
+        set(name, std::move(value), std::string(comment));
+    }
+
+    /// @copydoc PropertyList::set(std::string const&, std::string&&, std::string const&)
+    void set(std::string const& name, std::string&& value, char const* comment) {
+        set(name, std::move(value), std::string(comment));
+    }
+
     /// @copydoc PropertyList::add(std::string const&, T const&, std::string const&)
     template <typename T>
     void add(std::string const& name, T const& value, char const* comment) {
@@ -277,6 +392,17 @@ public:
         add(name, value, std::string(comment));
     }
 
+    /// @copydoc PropertyList::add(std::string const&, std::vector<T>&&, std::string const&)
+    template <typename T>
+    void add(std::string const& name, std::vector<T>&& value, char const* comment) {
+        add(name, std::move(value), std::string(comment));
+    }
+
+    /// @copydoc PropertyList::add(std::string const&, std::string&&, std::string const&)
+    void add(std::string const& name, std::string&& value, char const* comment) {
+        add(name, std::move(value), std::string(comment));
+    }
+
     //@{
     /// @copydoc PropertySet::copy
     virtual void copy(std::string const& dest, PropertySet const & source, std::string const& name,
@@ -286,21 +412,54 @@ public:
     //@{
     /// @copydoc PropertySet::combine
     virtual void combine(PropertySet const & source);
+    virtual void combine(PropertySet&& source);
     //@}
 
-    /// @copydoc PropertySet::remove
-    virtual void remove(std::string const& name);
+    /**
+     * Apply the edits of a patch made by PropertySetPatch::diff, including
+     * the comments of the names it adds or changes and, if it records one,
+     * the order of the names.
+     *
+     * @param[in] patch Edits to apply.
+     */
+    virtual void apply(PropertySetPatch const& patch);
+
+    using PropertySet::reserve;
+
+    /// @copydoc PropertySet::reserve(std::size_t)
+    virtual void reserve(std::size_t n);
+
+    /**
+     * Set many properties at once, with optional comments.
+     *
+     * The result is the same as calling set for each item in turn, with the
+     * comment if the item has one, but space is reserved once for all of
+     * them and new names are appended to the order without searching it.
+     *
+     * @param[in] items Names, values and comments to set, in order.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     *
+     * @warning May only partially set the items if an exception occurs.
+     */
+    virtual void setAll(std::vector<Item> items);
 
 private:
+    friend class PropertySetSnapshot;
+    friend class PropertySetPatch;
 
-    typedef std::unordered_map<std::string, std::string> CommentMap;
+    typedef detail::FlatMap<std::string> CommentMap;
 
-    virtual void _set(std::string const& name, std::shared_ptr<std::vector<std::any> > vp);
+    virtual void _set(std::string const& name, Values values);
+    virtual void _write(std::string& out, bool topLevelOnly, std::string const& indent) const;
+    virtual bool _remove(std::string_view name);
     virtual void _moveToEnd(std::string const& name);
     virtual void _commentOrderFix(std::string const& name, std::string const& comment);
+    virtual bool _sameContents(PropertySet const& other) const;
+    virtual std::list<std::string> const* _orderedNames() const { return &*_order; }
 
-    CommentMap _comments;
-    std::list<std::string> _order;
+    // Shared with deep copies until modified
+    detail::CopyOnWrite<CommentMap> _comments;
+    detail::CopyOnWrite<std::list<std::string>> _order;
 };
 
 #if defined(__ICC)
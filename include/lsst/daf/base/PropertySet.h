@@ -43,16 +43,27 @@
  * @ingroup daf_base
  */
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <typeinfo>
-#include <unordered_map>
+#include <utility>
 #include <vector>
-#include <any>
 #include <ostream>
 
 #include "lsst/base.h"
+#include "lsst/daf/base/DateTime.h"
 #include "lsst/daf/base/Persistable.h"
+#include "lsst/daf/base/detail/CopyOnWrite.h"
+#include "lsst/daf/base/detail/FlatMap.h"
+#include "lsst/daf/base/detail/ValueTypes.h"
 #include "lsst/pex/exceptions.h"
 
 namespace lsst {
@@ -64,12 +75,138 @@ namespace base {
 #pragma warning(disable : 444)
 #endif
 
+class FrozenPropertySet;
+class PropertySetSnapshot;
+class PropertySetPatch;
+
 class LSST_EXPORT PropertySet {
 public:
     // Typedefs
     typedef std::shared_ptr<PropertySet> Ptr;
     typedef std::shared_ptr<PropertySet const> ConstPtr;
 
+    /**
+     * Tag identifying the type of the values stored for a property.
+     *
+     * The set of supported value types is closed; there is one tag per type,
+     * in the same order as the explicit template instantiations.
+     */
+    enum class Type : std::uint8_t {
+        Bool,
+        Char,
+        SignedChar,
+        UnsignedChar,
+        Short,
+        UnsignedShort,
+        Int,
+        UnsignedInt,
+        Long,
+        UnsignedLong,
+        LongLong,
+        UnsignedLongLong,
+        Float,
+        Double,
+        Undef,  ///< std::nullptr_t
+        String,
+        PropertySet,  ///< std::shared_ptr<PropertySet>
+        Persistable,  ///< Persistable::Ptr
+        DateTime
+    };
+
+    /**
+     * A property name, possibly hierarchical, split and hashed once for repeated lookups.
+     *
+     * A Path can be used with any PropertySet or PropertyList.  Lookups through it
+     * give the same results as lookups through the name itself.
+     */
+    class Path {
+    public:
+        /**
+         * Precompile a property name.
+         *
+         * @param[in] name Property name, possibly hierarchical.
+         */
+        explicit Path(std::string name);
+
+        /// The property name
+        std::string const& getName() const noexcept { return _name; }
+
+    private:
+        friend class PropertySet;
+
+        // One dot-separated component of the name
+        struct Segment {
+            std::size_t begin;
+            std::size_t size;
+            std::size_t hash;
+        };
+
+        std::string _name;
+        std::size_t _hash;  // Hash of the whole name, for flat sets
+        std::vector<Segment> _segments;
+    };
+
+    /**
+     * A precompiled property name together with the type of its values.
+     *
+     * @code
+     * PropertySet::Key<int> const key("a.b.c");
+     * for (auto const& ps : sets) sum += ps->get(key);
+     * @endcode
+     */
+    template <typename T>
+    class Key : public Path {
+    public:
+        typedef T Value;
+
+        /**
+         * Precompile a property name for values of type T.
+         *
+         * @param[in] name Property name, possibly hierarchical.
+         */
+        explicit Key(std::string name) : Path(std::move(name)), _type(typeTagOfT<T>()) {}
+
+        /// The type tag for T
+        Type getType() const noexcept { return _type; }
+
+    private:
+        Type _type;
+    };
+
+    /**
+     * A read-only view of the values of a property, in place and without copying.
+     *
+     * A view is invalidated by any modification of the PropertySet it came
+     * from.  Strings are viewed as std::string_view; see ArrayView<std::string>.
+     */
+    template <typename T>
+    class ArrayView {
+    public:
+        typedef T value_type;
+        typedef T const* const_iterator;
+        typedef const_iterator iterator;
+
+        ArrayView() noexcept : _data(nullptr), _size(0) {}
+        ArrayView(T const* data, std::size_t size) noexcept : _data(data), _size(size) {}
+
+        T const* data() const noexcept { return _data; }
+        std::size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+
+        T const& operator[](std::size_t i) const noexcept { return _data[i]; }
+        T const& front() const noexcept { return _data[0]; }
+        T const& back() const noexcept { return _data[_size - 1]; }
+
+        const_iterator begin() const noexcept { return _data; }
+        const_iterator end() const noexcept { return _data + _size; }
+
+    private:
+        T const* _data;
+        std::size_t _size;
+    };
+
+    class Item;
+
     /**
      * Construct an empty PropertySet
      *
@@ -77,6 +214,39 @@ public:
      */
     explicit PropertySet(bool flat = false);
 
+    /**
+     * Construct an empty PropertySet whose storage comes from a memory resource.
+     *
+     * The name table, out-of-line value arrays, long names, and PropertySets
+     * created implicitly for hierarchical names are all allocated from
+     * resource, which must outlive the PropertySet.  Values set from another
+     * container are moved or copied into it.  The characters of std::string
+     * values are still allocated by std::string.
+     *
+     * @param[in] resource Memory resource to allocate from.
+     * @param[in] flat false (default) = flatten hierarchy by ignoring dots in names
+     */
+    explicit PropertySet(std::pmr::memory_resource* resource, bool flat = false);
+
+    /// The memory resource the PropertySet allocates from; std::pmr::new_delete_resource() by default
+    std::pmr::memory_resource* getMemoryResource() const noexcept;
+
+    /**
+     * Enable or disable interning of property names, process-wide.
+     *
+     * While enabled, names added to any PropertySet or PropertyList are
+     * stored once in a shared table, which saves memory and speeds up
+     * comparisons when many containers hold the same names.  Interned names
+     * are never freed, so only enable this when the set of names is bounded.
+     * Names stored before the change are unaffected.
+     *
+     * @param[in] enable Whether to intern names added from now on.
+     */
+    static void setNameInterning(bool enable);
+
+    /// Whether property names are interned; see setNameInterning
+    static bool getNameInterning();
+
     /// Destructor
     virtual ~PropertySet() noexcept;
 
@@ -84,19 +254,75 @@ public:
     PropertySet(const PropertySet&) = delete;
     PropertySet& operator=(const PropertySet&) = delete;
 
-    // No moving
-    PropertySet(PropertySet&&) = delete;
-    PropertySet& operator=(PropertySet&&) = delete;
+    /**
+     * Move constructor and assignment; the moved-from PropertySet is left
+     * empty.  Nested PropertySets are moved by pointer, not copied.
+     */
+    PropertySet(PropertySet&& other) noexcept;
+    PropertySet& operator=(PropertySet&& other) noexcept;
 
     // Accessors
 
     /**
      * Make a deep copy of the PropertySet and all of its contents.
      *
+     * The copy allocates from the same memory resource as the original.
+     *
      * @return PropertySet pointing to the new copy.
      */
     virtual std::shared_ptr<PropertySet> deepCopy() const;
 
+    /**
+     * Compare two PropertySets by contents.
+     *
+     * They are equal if they are of the same class and hold the same names,
+     * each with the same number of values of the same type, equal element by
+     * element.  A NaN equals any other NaN, and nested PropertySets are
+     * compared by contents.  PropertyLists must also have the same order of
+     * names and the same comments.  The comparison stops at the first
+     * difference, and storage shared by deep copies is not compared at all.
+     */
+    bool operator==(PropertySet const& other) const;
+    bool operator!=(PropertySet const& other) const { return !(*this == other); }
+
+    /**
+     * A 64-bit fingerprint of the names, types and values, for use as a
+     * cache key.
+     *
+     * Sets that compare equal have the same fingerprint, whatever the order
+     * their properties were set in, and the fingerprint of given contents
+     * is the same in every process and on every platform.  It is kept up to
+     * date as the set is modified, so this takes constant time unless the
+     * set holds PropertySets, whose fingerprints are combined on each call.
+     * Persistables contribute only their number.  This is not a
+     * cryptographic hash: different contents may, rarely, collide.
+     */
+    std::uint64_t fingerprint() const;
+
+    /**
+     * Make an immutable snapshot of the PropertySet and all of its contents.
+     *
+     * The snapshot may be read from any number of threads without locking,
+     * and looks up names of any depth with a single probe.  A PropertyList
+     * keeps its order and comments.
+     *
+     * @return Pointer to the snapshot.
+     */
+    std::shared_ptr<FrozenPropertySet const> freeze() const;
+
+    /**
+     * Take a read-only snapshot of the PropertySet and all of its contents.
+     *
+     * The snapshot shares storage with the PropertySet instead of copying
+     * it, and keeps its contents while the PropertySet goes on being
+     * modified; only the parts that are modified are then copied.  It must
+     * be taken by the thread that modifies the PropertySet, but may be read
+     * from any thread.  A PropertyList keeps its order and comments.
+     *
+     * @return Pointer to the snapshot.
+     */
+    std::shared_ptr<PropertySetSnapshot const> snapshot() const;
+
     /**
      * Get the number of names in the PropertySet, optionally including those in subproperties.
      *
@@ -124,13 +350,32 @@ public:
      */
     std::vector<std::string> propertySetNames(bool topLevelOnly = true) const;
 
+    class Entry;
+    class EntryIterator;
+    class EntryRange;
+
+    /**
+     * Iterate over the properties without building a list of names.
+     *
+     * @code for (auto const& entry : propertySet.entries(false)) count += entry.size(); @endcode
+     *
+     * Entries come in the same order as @ref names, or in the order of
+     * PropertyList::getOrderedNames for a PropertyList.  Iterating over the
+     * top level allocates nothing; iterating recursively keeps the dotted
+     * name of the current entry in a single buffer.  Iterators and entries
+     * are invalidated by any modification of the PropertySet.
+     *
+     * @param[in] topLevelOnly If true (default) omit names from subproperties.
+     */
+    EntryRange entries(bool topLevelOnly = true) const;
+
     /**
      * Determine if a name (possibly hierarchical) exists.
      *
      * @param[in] name Property name to examine, possibly hierarchical.
      * @return true if property exists.
      */
-    bool exists(std::string const& name) const;
+    bool exists(std::string_view name) const;
 
     /**
      * Determine if a name (possibly hierarchical) has multiple values.
@@ -138,7 +383,7 @@ public:
      * @param[in] name Property name to examine, possibly hierarchical.
      * @return true if property exists and has more than one value.
      */
-    bool isArray(std::string const& name) const;
+    bool isArray(std::string_view name) const;
 
     /**
      * Determine if a name (possibly hierarchical) is a subproperty.
@@ -146,7 +391,7 @@ public:
      * @param[in] name Property name to examine, possibly hierarchical.
      * @return true if property exists and its values are PropertySet:.
      */
-    bool isPropertySetPtr(std::string const& name) const;
+    bool isPropertySetPtr(std::string_view name) const;
 
     /**
      * Determine if a name (possibly hierarchical) has a defined value.
@@ -154,7 +399,7 @@ public:
      * @param[in] name Property name to examine, possibly hierarchical.
      * @return true if property exists and its values are undefined.
      */
-    bool isUndefined(std::string const& name) const;
+    bool isUndefined(std::string_view name) const;
 
     /**
      * Get the number of values in the entire PropertySet, counting each
@@ -170,7 +415,7 @@ public:
      * @param[in] name Property name to examine, possibly hierarchical.
      * @return Number of values for that property.  0 if it doesn't exist.
      */
-    size_t valueCount(std::string const& name) const;
+    size_t valueCount(std::string_view name) const;
 
     /**
      * Get the type of values for a property name (possibly hierarchical).
@@ -181,7 +426,7 @@ public:
      * @return Type of values for that property.
      * @throws NotFoundError Property does not exist.
      */
-    std::type_info const& typeOf(std::string const& name) const;
+    std::type_info const& typeOf(std::string_view name) const;
 
     /**
      * Get type info for the specified class
@@ -191,6 +436,24 @@ public:
     template <typename T>
     static std::type_info const& typeOfT();
 
+    /**
+     * Get the type tag of values for a property name (possibly hierarchical).
+     *
+     * This is cheaper than @ref typeOf and is the preferred way to dispatch
+     * on the type of a property.
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return Type tag of values for that property.
+     * @throws NotFoundError Property does not exist.
+     */
+    Type typeTag(std::string_view name) const;
+
+    /**
+     * Get the type tag for the specified class
+     */
+    template <typename T>
+    static Type typeTagOfT();
+
     // The following throw an exception if the type does not match exactly.
 
     /**
@@ -205,7 +468,7 @@ public:
      * @throws TypeError Value does not match desired type.
      */
     template <typename T>
-    T get(std::string const& name) const;
+    T get(std::string_view name) const;
 
     /**
      * Get the last value for a property name (possibly hierarchical);
@@ -220,7 +483,7 @@ public:
      * @throws TypeError Value does not match desired type.
      */
     template <typename T>
-    T get(std::string const& name, T const& defaultValue) const;
+    T get(std::string_view name, T const& defaultValue) const;
 
     /**
      * Get the vector of values for a property name (possibly hierarchical).
@@ -234,7 +497,134 @@ public:
      * @throws TypeError Value does not match desired type.
      */
     template <typename T>
-    std::vector<T> getArray(std::string const& name) const;
+    std::vector<T> getArray(std::string_view name) const;
+
+    /**
+     * Get a view of the values for a property name (possibly hierarchical)
+     * without copying them.
+     *
+     * Note that the type must be explicitly specified for this template:
+     * @code for (double x : propertySet.getArrayView<double>("foo")) ... @endcode
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return View of the values, valid until this PropertySet is modified.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    ArrayView<T> getArrayView(std::string_view name) const;
+
+    /**
+     * Copy the values for a property name (possibly hierarchical) into a
+     * caller-owned buffer.
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @param[out] buffer Buffer to receive the values.
+     * @param[in] size Number of values the buffer can hold.
+     * @return Number of values copied.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     * @throws LengthError Buffer is too small for the values.
+     */
+    template <typename T>
+    std::size_t getArrayInto(std::string_view name, T* buffer, std::size_t size) const;
+
+    // The following return nothing, rather than throwing, if the property
+    // does not exist or the type does not match exactly; they are meant for
+    // probing optional properties.
+
+    /**
+     * Get the last value for a property name (possibly hierarchical), if it
+     * exists and is of type T.
+     *
+     * Note that the type must be explicitly specified for this template:
+     * @code if (auto exptime = propertySet.tryGet<double>("EXPTIME")) ... @endcode
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return Last value set or added, or nothing.
+     */
+    template <typename T>
+    std::optional<T> tryGet(std::string_view name) const;
+
+    /**
+     * Get the vector of values for a property name (possibly hierarchical),
+     * if it exists and is of type T.
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return Vector of values, or nothing.
+     */
+    template <typename T>
+    std::optional<std::vector<T>> tryGetArray(std::string_view name) const;
+
+    /**
+     * Get the type tag of values for a property name (possibly hierarchical),
+     * if it exists.
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return Type tag of values for that property, or nothing.
+     */
+    std::optional<Type> tryTypeTag(std::string_view name) const noexcept;
+
+    /**
+     * Get the type of values for a property name (possibly hierarchical),
+     * if it exists.
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return Type of values for that property, or null.
+     */
+    std::type_info const* tryTypeOf(std::string_view name) const noexcept;
+
+    /**
+     * Call a visitor on the values for a property name (possibly
+     * hierarchical), with their native type.
+     *
+     * The visitor is called once, as visitor(ArrayView<T>) for the type T of
+     * the values, which is found through a jump table.  It may be a generic
+     * lambda or a set of overloads for every supported type:
+     * @code
+     * propertySet.visit("foo", [&](auto const& values) { for (auto const& v : values) out << v; });
+     * @endcode
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @param[in] visitor Callable taking an ArrayView of any supported type.
+     * @return The result of the visitor, which must be of the same type for every T.
+     * @throws NotFoundError Property does not exist.
+     */
+    template <typename Visitor>
+    decltype(auto) visit(std::string_view name, Visitor&& visitor) const {
+        return _visit(_at(name), std::forward<Visitor>(visitor));
+    }
+
+    /**
+     * Call a visitor on the values of every property, with their native type.
+     *
+     * The visitor is called as visitor(name, ArrayView<T>) for each property,
+     * in the order of entries(topLevelOnly); see visit.
+     *
+     * @param[in] visitor Callable taking a std::string_view and an ArrayView of any supported type.
+     * @param[in] topLevelOnly If true (default) omit names from subproperties.
+     */
+    template <typename Visitor>
+    void visitAll(Visitor&& visitor, bool topLevelOnly = true) const;
+
+    /**
+     * Get the last value for a precompiled property name.
+     *
+     * @param[in] key Precompiled property name and value type.
+     * @return Last value set or added.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match the type of the key.
+     */
+    template <typename T>
+    T get(Key<T> const& key) const;
+
+    /**
+     * Determine if a precompiled property name exists.
+     *
+     * @param[in] path Precompiled property name.
+     * @return true if property exists.
+     */
+    bool exists(Path const& path) const;
 
     // The following throw an exception if the conversion is inappropriate.
 
@@ -248,7 +638,7 @@ public:
      * @throws NotFoundError Property does not exist.
      * @throws TypeError Value is not a bool.
      */
-    bool getAsBool(std::string const& name) const;
+    bool getAsBool(std::string_view name) const;
 
     /**
      * Get the last value for a bool/char/short/int property name (possibly
@@ -259,7 +649,7 @@ public:
      * @throws NotFoundError Property does not exist.
      * @throws TypeError Value cannot be converted to int.
      */
-    int getAsInt(std::string const& name) const;
+    int getAsInt(std::string_view name) const;
 
     /**
      * Get the last value for a bool/char/short/int/int64_t property name
@@ -272,7 +662,7 @@ public:
      * @throws NotFoundError Property does not exist.
      * @throws TypeError Value cannot be converted to int64_t.
      */
-    int64_t getAsInt64(std::string const& name) const;
+    int64_t getAsInt64(std::string_view name) const;
 
     /**
      * Get the last value for an bool/char/short/int/int64_t property name
@@ -283,7 +673,7 @@ public:
      * @throws NotFoundError Property does not exist.
      * @throws TypeError Value cannot be converted to uint64_t.
      */
-    uint64_t getAsUInt64(std::string const& name) const;
+    uint64_t getAsUInt64(std::string_view name) const;
 
     /**
      * Get the last value for any arithmetic property name (possibly
@@ -294,7 +684,7 @@ public:
      * @throws NotFoundError Property does not exist.
      * @throws TypeError Value cannot be converted to double.
      */
-    double getAsDouble(std::string const& name) const;
+    double getAsDouble(std::string_view name) const;
 
     /**
      * Get the last value for a string property name (possibly hierarchical).
@@ -307,7 +697,7 @@ public:
      * @throws NotFoundError Property does not exist.
      * @throws TypeError Value is not a string.
      */
-    std::string getAsString(std::string const& name) const;
+    std::string getAsString(std::string_view name) const;
 
     /**
      * Get the last value for a subproperty name (possibly hierarchical).
@@ -317,7 +707,7 @@ public:
      * @throws NotFoundError Property does not exist.
      * @throws TypeError Value is not a PropertySet.
      */
-    std::shared_ptr<PropertySet> getAsPropertySetPtr(std::string const& name) const;
+    std::shared_ptr<PropertySet> getAsPropertySetPtr(std::string_view name) const;
 
     /**
      * Get the last value for a Persistable name (possibly hierarchical).
@@ -327,7 +717,7 @@ public:
      * @throws NotFoundError Property does not exist.
      * @throws TypeError Value is not a Persistable::Ptr.
      */
-    Persistable::Ptr getAsPersistablePtr(std::string const& name) const;
+    Persistable::Ptr getAsPersistablePtr(std::string_view name) const;
 
     /**
      * Generate a string representation of the PropertySet.
@@ -370,6 +760,27 @@ public:
     template <typename T>
     void set(std::string const& name, std::vector<T> const& value);
 
+    /**
+     * Replace all values for a property name (possibly hierarchical) with a
+     * vector of new values, moving them out of the vector.
+     *
+     * @param[in] name Property name to set, possibly hierarchical.
+     * @param[in] value Vector of values to set; left in a valid but unspecified state.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void set(std::string const& name, std::vector<T>&& value);
+
+    /**
+     * Replace all values for a property name (possibly hierarchical) with a
+     * string value, moving the string's characters instead of copying them.
+     *
+     * @param[in] name Property name to set, possibly hierarchical.
+     * @param[in] value String to set; left in a valid but unspecified state.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    void set(std::string const& name, std::string&& value);
+
     /**
      * Replace all values for a property name (possibly hierarchical) with a
      * string value.
@@ -379,6 +790,20 @@ public:
      */
     void set(std::string const& name, char const* value);
 
+    /**
+     * Replace all values for a precompiled property name with a new scalar
+     * value.
+     *
+     * If the property already holds values of the key's type they are
+     * replaced in place; otherwise this behaves like set(key.getName(), value).
+     *
+     * @param[in] key Precompiled property name and value type.
+     * @param[in] value Value to set.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void set(Key<T> const& key, typename Key<T>::Value const& value);
+
     /**
      * Append a single value to the vector of values for a property name
      * (possibly hierarchical).  Sets the value if the property does not exist.
@@ -411,6 +836,31 @@ public:
     template <typename T>
     void add(std::string const& name, std::vector<T> const& value);
 
+    /**
+     * Append a vector of values to the vector of values for a property name
+     * (possibly hierarchical), moving them out of the vector.  Sets the
+     * values if the property does not exist.
+     *
+     * @param[in] name Property name to append to, possibly hierarchical.
+     * @param[in] value Vector of values to append; left in a valid but unspecified state.
+     * @throws TypeError Type does not match existing values.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    template <typename T>
+    void add(std::string const& name, std::vector<T>&& value);
+
+    /**
+     * Append a string to the vector of values for a property name (possibly
+     * hierarchical), moving its characters instead of copying them.  Sets
+     * the value if the property does not exist.
+     *
+     * @param[in] name Property name to append to, possibly hierarchical.
+     * @param[in] value String to append; left in a valid but unspecified state.
+     * @throws TypeError Type does not match existing values.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     */
+    void add(std::string const& name, std::string&& value);
+
     /**
      * Append a <tt>char const*</tt> value to the vector of values for a
      * property name (possibly hierarchical).  Sets the value if the property
@@ -423,6 +873,19 @@ public:
      */
     void add(std::string const& name, char const* value);
 
+    /**
+     * Make room for a property name (possibly hierarchical) to hold at least
+     * \a n values without reallocating.
+     *
+     * Appending already takes amortized constant time; reserving just avoids
+     * the intermediate reallocations when the final count is known.
+     *
+     * @param[in] name Property name to reserve space for, possibly hierarchical.
+     * @param[in] n Number of values to make room for.
+     * @throws NotFoundError Property does not exist.
+     */
+    void reserve(std::string const& name, std::size_t n);
+
     //@{
     /**
      * Replace a single value vector in the destination with one from the
@@ -456,6 +919,23 @@ public:
      * @warning May only partially combine the PropertySets if an exception occurs.
      */
     virtual void combine(PropertySet const & source);
+
+    /**
+     * Append all value vectors from the \a source to their corresponding
+     * properties, moving values out of \a source instead of copying them
+     * where possible.  Otherwise the same as combine(PropertySet const&).
+     *
+     * @param[in] source PropertySet to extract values from; left empty.
+     * @throws TypeError Type does not match existing values for an item.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     *
+     * @warning May only partially combine the PropertySets if an exception
+     * occurs.  Values are moved only from properties held directly by \a
+     * source (all of them, if it is flat); those already combined are then
+     * removed from \a source.  Properties of nested PropertySets are copied
+     * and stay in \a source, as do those not yet combined.
+     */
+    virtual void combine(PropertySet&& source);
     //@}
 
     /**
@@ -466,68 +946,714 @@ public:
      */
     virtual void remove(std::string const& name);
 
+    /**
+     * Apply the edits of a patch made by PropertySetPatch::diff: remove the
+     * names it removes, and set the names it adds or changes to deep copies
+     * of their new values.
+     *
+     * @param[in] patch Edits to apply.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     *
+     * @warning May only partially apply the patch if an exception occurs.
+     */
+    virtual void apply(PropertySetPatch const& patch);
+
+    /**
+     * Make room for at least \a n top-level property names without rehashing.
+     *
+     * @param[in] n Number of names to make room for.
+     */
+    virtual void reserve(std::size_t n);
+
+    /**
+     * Set many properties at once.
+     *
+     * The result is the same as calling set for each item in turn, but
+     * space is reserved once for all of them, and items that are neither
+     * hierarchical nor PropertySets are stored without the per-call
+     * bookkeeping of set.  Items holding an empty vector are skipped, and
+     * comments are ignored except by PropertyList.
+     *
+     * @code
+     * ps.setAll({{"EXPTIME", 30.0}, {"FILTER", "r", "Filter name"}});
+     * @endcode
+     *
+     * @param[in] items Names and values to set, in order.
+     * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
+     *
+     * @warning May only partially set the items if an exception occurs.
+     */
+    virtual void setAll(std::vector<Item> items);
+
+    // Journal
+
+    /// A modification recorded by the journal; see setJournaling
+    struct Change {
+        enum class Kind : std::uint8_t {
+            Set,     ///< Values replaced (set, copy, or the first add)
+            Add,     ///< Values appended (add, combine)
+            Remove,  ///< Property removed
+        };
+
+        Kind kind;
+        std::string name;  ///< Property name, possibly hierarchical
+    };
+
+    /**
+     * Turn the modification journal on or off.
+     *
+     * While the journal is on, every set, add, remove, copy and combine
+     * made through this PropertySet is recorded, in order, so that a writer
+     * can save only what changed since the last checkpoint (takeJournal).
+     * Turning it on starts an empty journal; turning it off discards it.
+     * Changes made directly to nested PropertySets are recorded by their own
+     * journals, not this one.
+     *
+     * @param[in] enable Whether to record modifications.
+     */
+    void setJournaling(bool enable);
+
+    /// Whether the modification journal is on; see setJournaling
+    bool isJournaling() const noexcept { return _journal != nullptr; }
+
+    /// The modifications recorded since journaling was turned on or last taken
+    std::vector<Change> const& getJournal() const noexcept;
+
+    /**
+     * Return the modifications recorded so far and start a new, empty
+     * journal; the checkpoint for incremental persistence.
+     *
+     * @return Modifications in the order they were made; empty if journaling is off.
+     */
+    std::vector<Change> takeJournal();
+
 protected:
+    /*
+     * Values of a single property, all of exactly one of the supported types,
+     * in a compact 16-byte cell.
+     *
+     * A single arithmetic, undefined or DateTime value, or a single string of
+     * up to 14 characters, is stored inline.  Anything else (more than one
+     * value, a longer string, PropertySet and Persistable pointers) is stored
+     * in an out-of-line array of the native type, which is created when the
+     * cell first needs it and grows geometrically as values are appended, so
+     * building an array one value at a time takes linear time.
+     */
+    class Values {
+    public:
+        // Out-of-line arrays created by the following come from resource, or
+        // from operator new if it is null.
+
+        /// Hold a single value
+        template <typename T>
+        explicit Values(T const& value, std::pmr::memory_resource* resource = nullptr);
+
+        /// Hold a copy of a non-empty vector of values
+        template <typename T>
+        explicit Values(std::vector<T> const& values, std::pmr::memory_resource* resource = nullptr);
+
+        /// Hold a non-empty vector of values, moved out of the vector
+        template <typename T>
+        explicit Values(std::vector<T>&& values, std::pmr::memory_resource* resource = nullptr);
+
+        /// Hold a single string, moved into the cell
+        explicit Values(std::string&& value, std::pmr::memory_resource* resource = nullptr);
+
+        Values(Values const& other);
+        Values(Values&& other) noexcept;
+        Values& operator=(Values const& other);
+        Values& operator=(Values&& other) noexcept;
+        ~Values() noexcept;
+
+        /// Type tag of the values
+        Type type() const { return _type; }
+
+        /// Number of values
+        std::size_t size() const;
+
+        // The following require T to match type() exactly.
+
+        /// Last value
+        template <typename T>
+        T back() const;
+
+        /// Copy of all values
+        template <typename T>
+        std::vector<T> toVector() const;
+
+        /// View of all values
+        template <typename T>
+        ArrayView<T> view() const;
+
+        /// Append one value
+        template <typename T>
+        void append(T const& value, std::pmr::memory_resource* resource = nullptr);
+
+        /// Append a vector of values
+        template <typename T>
+        void append(std::vector<T> const& values, std::pmr::memory_resource* resource = nullptr);
+
+        /// Append a vector of values, moved out of the vector
+        template <typename T>
+        void append(std::vector<T>&& values, std::pmr::memory_resource* resource = nullptr);
+
+        /// Append one string, moved into the cell
+        void append(std::string&& value, std::pmr::memory_resource* resource = nullptr);
+
+        /// Append the values of another cell of the same type
+        void append(Values const& other, std::pmr::memory_resource* resource = nullptr);
+
+        /// Append the values of another cell of the same type, moving them if it is not shared
+        void append(Values&& other, std::pmr::memory_resource* resource = nullptr);
+
+        /// Make room for at least n values
+        void reserve(std::size_t n, std::pmr::memory_resource* resource = nullptr);
+
+        /// Copy of the last value only
+        Values lastOnly(std::pmr::memory_resource* resource = nullptr) const;
+
+        /// Make sure any out-of-line array comes from resource, copying it if not
+        void rebind(std::pmr::memory_resource* resource);
+
+        /// Call f(T const* data, std::size_t size) on the values with their native type T
+        template <typename F>
+        void visit(F&& f) const;
+
+    private:
+        friend class PropertySet::Item;  // Holds an empty cell for an empty vector
+
+        struct Block;  // Out-of-line array; also hosts the storage helpers
+
+        static constexpr std::size_t INLINE_SIZE = 14;
+        static constexpr std::uint8_t OUT_OF_LINE = 0x80;
+
+        Values() noexcept : _type(Type::Undef), _state(0) {}
+
+        alignas(8) unsigned char _data[INLINE_SIZE];  // inline value, or Block pointer
+        Type _type;
+        std::uint8_t _state;  // OUT_OF_LINE, or the length of an inline string
+    };
+
     /*
      * Find the property name (possibly hierarchical) and set or replace its
-     * value with the given vector of values.  Hook for subclass overrides of
+     * value with the given values.  Hook for subclass overrides of
      * top-level setting.
      *
      * @param[in] name Property name to find, possibly hierarchical.
-     * @param[in] vp shared_ptr to vector of values.
+     * @param[in] values Values to set.
      * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
      */
-    virtual void _set(std::string const& name, std::shared_ptr<std::vector<std::any> > vp);
+    virtual void _set(std::string const& name, Values values);
 
     /*
      * Find the property name (possibly hierarchical) and append or set its
-     * value with the given vector of values.
+     * value with the given values.
      *
      * @param[in] name Property name to find, possibly hierarchical.
-     * @param[in] vp shared_ptr to vector of values.
+     * @param[in] values Values to append.
      * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
      */
-    virtual void _add(std::string const& name, std::shared_ptr<std::vector<std::any> > vp);
+    virtual void _add(std::string const& name, Values values);
+
+    // Append the string representation to out; called by toString and operator<<
+    virtual void _write(std::string& out, bool topLevelOnly, std::string const& indent) const;
+
+    // Append a line giving the values of a top-level property in human-readable form to out
+    virtual void _format(std::string& out, std::string_view name) const;
+
+    // Whether this set and other, which is of the same class, have the same
+    // contents; called by operator==
+    virtual bool _sameContents(PropertySet const& other) const;
+
+    // Remove all values for a property name (possibly hierarchical) without
+    // recording the change; returns whether there were any to remove
+    virtual bool _remove(std::string_view name);
+
+    // The names in the order entries() visits them, or null for the order of the map
+    virtual std::list<std::string> const* _orderedNames() const { return nullptr; }
+
+    /*
+     * Make this empty set a deep copy of another.  Maps that hold no nested
+     * PropertySets are shared with the source until either is modified, and
+     * value arrays are shared until either copy changes them.
+     *
+     * @param[in] source PropertySet to copy.
+     */
+    void _deepCopyFrom(PropertySet const& source);
+
+    /*
+     * Add deep copies of the entries of another set, none of whose top-level
+     * names may already be in this one.
+     *
+     * @param[in] source PropertySet to copy.
+     */
+    void _mergeCopyFrom(PropertySet const& source);
+
+    /*
+     * Whether an item can be stored with _setTopLevel: it holds values and
+     * is neither hierarchical nor a PropertySet.
+     */
+    bool _isTopLevel(Item const& item) const;
 
-    // Format a value in human-readable form; called by toString
-    virtual std::string _format(std::string const& name) const;
+    /*
+     * Set the values of a top-level property directly, without calling _set.
+     *
+     * @param[in] name Property name, which must not be hierarchical unless this set is flat.
+     * @param[in] values Values to set; PropertySets are stored as they are, neither
+     *                   flattened nor checked for cycles.
+     * @return Whether the property is new.
+     */
+    bool _setTopLevel(std::string const& name, Values values);
 
 private:
 
-    typedef std::unordered_map<std::string, std::shared_ptr<std::vector<std::any> > > AnyMap;
+    typedef detail::FlatMap<Values> AnyMap;
 
     /*
      * Find the property name (possibly hierarchical).
      *
+     * The entry found may be in a nested set's map, so a miss is reported
+     * with a null pointer rather than an end iterator of any one map.
+     *
      * @param[in] name Property name to find, possibly hierarchical.
-     * @return unordered_map::iterator to the property or end() if nonexistent.
+     * @param[out] owner If not null, set to the PropertySet holding the property.
+     * @return Pointer to the property's entry, or null if nonexistent.
      */
-    AnyMap::iterator _find(std::string const& name);
+    AnyMap::value_type* _find(std::string_view name, PropertySet** owner = nullptr);
 
     /*
      * Find the property name (possibly hierarchical).  Const version.
      *
      * @param[in] name Property name to find, possibly hierarchical.
-     * @return unordered_map::const_iterator to the property or end().
+     * @return Pointer to the property's entry, or null if nonexistent.
+     */
+    AnyMap::value_type const* _find(std::string_view name) const;
+
+    /*
+     * Find a property through a precompiled name.
+     *
+     * @param[out] owner If not null, set to the PropertySet holding the property.
+     * @return Pointer to the property's entry, or null if nonexistent.
+     */
+    AnyMap::value_type* _find(Path const& path, PropertySet** owner = nullptr);
+    AnyMap::value_type const* _find(Path const& path) const;
+
+    /*
+     * Find a key in this set's own map, unsharing the map only if the key is
+     * there, since the entry found may be modified.
+     *
+     * @param[in] key Key to find, not split at dots.
+     * @param[in] keyHash Hash of the key, as from AnyMap::hash.
+     * @return Pointer to the key's entry, or null if the key is not there.
+     */
+    AnyMap::value_type* _findLocal(std::string_view key, std::size_t keyHash);
+
+    /*
+     * Whether _add would take values under name without throwing, so that
+     * they may be moved in without risk of losing them.
      */
-    AnyMap::const_iterator _find(std::string const& name) const;
+    bool _accepts(std::string_view name, Values const& values) const;
 
     /*
      * Find the property name (possibly hierarchical) and set or replace its
-     * value with the given vector of values.
+     * value with the given values.
      *
      * @param[in] name Property name to find, possibly hierarchical.
-     * @param[in] vp shared_ptr to vector of values.
+     * @param[in] values Values to set.
      * @throws InvalidParameterError Hierarchical name uses non-PropertySet.
      */
-    virtual void _findOrInsert(std::string const& name, std::shared_ptr<std::vector<std::any> > vp);
-    void _cycleCheckPtrVec(std::vector<std::shared_ptr<PropertySet>> const& v, std::string const& name);
-    void _cycleCheckAnyVec(std::vector<std::any> const& v, std::string const& name);
-    void _cycleCheckPtr(std::shared_ptr<PropertySet> const & v, std::string const& name);
+    virtual void _findOrInsert(std::string_view name, Values values);
+
+    /*
+     * Throw InvalidParameterError if this set is reachable from any of the
+     * given sets, so that adding them under name would make a cycle.  Takes
+     * time linear in the number of distinct sets reachable.
+     */
+    void _cycleCheckPtrVec(ArrayView<std::shared_ptr<PropertySet>> v, std::string_view name);
+    void _cycleCheckPtr(std::shared_ptr<PropertySet> const& v, std::string_view name);
+
+    friend class ConcurrentPropertySet;
+    friend class FrozenPropertySet;
+    friend class PropertySetSnapshot;
+    friend class PropertySetPatch;
+    friend std::ostream& operator<<(std::ostream& os, PropertySet const& propertySet);
+
+    /*
+     * Append the fully qualified name and the values of every property,
+     * including those in subproperties, to entries.
+     *
+     * @param[in] prefix Prefix for the names, empty or ending in a dot.
+     * @param[out] entries Names and values; the values stay owned by this set.
+     */
+    void _collect(std::string const& prefix,
+                  std::vector<std::pair<std::string, Values const*>>& entries) const;
+
+    // Typed access to the values of property name, which must be of type T;
+    // shared with FrozenPropertySet
+    template <typename T>
+    static T _back(Values const& values, std::string_view name);
+    template <typename T>
+    static std::vector<T> _toVector(Values const& values, std::string_view name);
+    template <typename T>
+    static ArrayView<T> _view(Values const& values, std::string_view name);
+    static std::type_info const& _typeOf(Values const& values);
+
+    // Call visitor(ArrayView<T>) on values, with their native type T
+    template <typename Visitor>
+    static decltype(auto) _visit(Values const& values, Visitor&& visitor) {
+        auto const call = [&values, &visitor](auto t) -> decltype(auto) {
+            return visitor(_view<typename decltype(t)::type>(values, std::string_view()));
+        };
+        return detail::dispatch(static_cast<std::size_t>(values.type()), call);
+    }
+
+    // The values of property name; throws NotFoundError if it does not exist
+    Values const& _at(std::string_view name) const;
+
+    // Whether two cells hold the same values, with NaNs equal to each other
+    // and nested PropertySets compared by contents
+    static bool _equal(Values const& a, Values const& b);
+
+    // A copy of values in which nested PropertySets are deep copies
+    static Values _isolate(Values const& values, std::pmr::memory_resource* resource);
+
+    // A copy of a value, or of a vector of them, in which nested PropertySets
+    // are deep copies; for classes that hand values across a boundary
+    template <typename T>
+    static T _isolate(T const& value) {
+        if constexpr (std::is_same<T, std::shared_ptr<PropertySet>>::value) {
+            return value ? value->deepCopy() : value;
+        } else {
+            return value;
+        }
+    }
+
+    template <typename T>
+    static std::vector<T> _isolate(std::vector<T> const& values) {
+        if constexpr (std::is_same<T, std::shared_ptr<PropertySet>>::value) {
+            std::vector<T> result;
+            result.reserve(values.size());
+            for (auto const& value : values) {
+                result.push_back(_isolate(value));
+            }
+            return result;
+        } else {
+            return values;
+        }
+    }
+
+    // The memory resource, or null for operator new
+    std::pmr::memory_resource* _resource() const noexcept { return _map.getResource(); }
+
+    // Make an empty PropertySet that allocates from the same resource as this one
+    std::shared_ptr<PropertySet> _makeEmpty(bool flat) const;
+
+    /*
+     * The part of the fingerprint contributed by the values of a property,
+     * from index from onwards; nested PropertySets contribute nothing here,
+     * since they may change behind this set's back.  Depends on the order of
+     * Type, which must not change.
+     */
+    static std::uint64_t _contribution(std::string_view key, Values const& values, std::size_t from = 0);
+
+    // Store values under a top-level key, keeping the fingerprint up to
+    // date; returns whether the key is new
+    bool _store(std::string_view key, Values values);
 
-    AnyMap _map;
+    // Account in the fingerprint for the values appended to a property from index from onwards
+    void _appended(AnyMap::value_type const& entry, std::size_t from) {
+        _fingerprint += _contribution(entry.first.view(), entry.second, from);
+    }
+
+    // Recompute the fingerprint from scratch
+    void _rehash();
+
+    // Record a modification if journaling is on
+    void _record(Change::Kind kind, std::string_view name) {
+        if (_journal) {
+            _journal->push_back(Change{kind, std::string(name)});
+        }
+    }
+
+    // Shared with deep copies until modified
+    detail::CopyOnWrite<AnyMap> _map;
     bool _flat;
+    std::unique_ptr<std::vector<Change>> _journal;  // Null unless journaling
+    std::uint64_t _fingerprint;  // Sum of _contribution over the properties, modulo 2^64
+    std::size_t _nestedCount;    // Number of properties holding PropertySets
+};
+
+/**
+ * A property name with its values, and optionally a comment, for PropertySet::setAll.
+ *
+ * Items are usually built in place from braced lists:
+ * @code {"name", value} @endcode or @code {"name", value, "comment"} @endcode
+ */
+class PropertySet::Item {
+public:
+    /**
+     * Hold a scalar value.
+     *
+     * @param[in] name Property name, possibly hierarchical.
+     * @param[in] value Value to set.
+     * @param[in] comment Comment to set, if any.
+     */
+    template <typename T>
+    Item(std::string name, T const& value, std::optional<std::string> comment = std::nullopt);
+
+    /**
+     * Hold a vector of values; an item with an empty vector sets nothing.
+     *
+     * @param[in] name Property name, possibly hierarchical.
+     * @param[in] value Values to set.
+     * @param[in] comment Comment to set, if any.
+     */
+    template <typename T>
+    Item(std::string name, std::vector<T> const& value, std::optional<std::string> comment = std::nullopt);
+
+    /// Hold a string value; see above
+    Item(std::string name, char const* value, std::optional<std::string> comment = std::nullopt);
+
+    std::string const& getName() const noexcept { return _name; }
+    std::optional<std::string> const& getComment() const noexcept { return _comment; }
+
+    /// Whether the item holds no values
+    bool empty() const noexcept { return _empty; }
+
+private:
+    friend class PropertySet;
+    friend class PropertyList;
+    friend class PropertySetPatch;
+
+    // The PropertySet the item holds, or null if it holds values of another type
+    std::shared_ptr<PropertySet> _getPropertySet() const;
+
+    std::string _name;
+    Values _values;
+    bool _empty;
+    std::optional<std::string> _comment;
+};
+
+/**
+ * A property seen through PropertySet::entries: its name and its values, in place.
+ *
+ * An entry is invalidated by any modification of the PropertySet it came from.
+ */
+class PropertySet::Entry {
+public:
+    /// Property name; hierarchical if the iteration is recursive
+    std::string_view getName() const noexcept { return _name; }
+
+    /// Type tag of the values
+    Type getType() const noexcept { return _values->type(); }
+
+    /// Number of values
+    std::size_t size() const { return _values->size(); }
+
+    /// Whether the property has more than one value
+    bool isArray() const { return size() > 1U; }
+
+    /**
+     * Get the last value.
+     *
+     * @throws TypeError Type does not match.
+     */
+    template <typename T>
+    T get() const {
+        return _back<T>(*_values, _name);
+    }
+
+    /**
+     * View all of the values without copying them.
+     *
+     * @throws TypeError Type does not match.
+     */
+    template <typename T>
+    ArrayView<T> getArrayView() const {
+        return _view<T>(*_values, _name);
+    }
+
+    /// Call visitor(ArrayView<T>) on the values, with their native type T; see PropertySet::visit
+    template <typename Visitor>
+    decltype(auto) visit(Visitor&& visitor) const {
+        return _visit(*_values, std::forward<Visitor>(visitor));
+    }
+
+private:
+    friend class EntryIterator;
+
+    Entry(std::string_view name, Values const& values) noexcept : _name(name), _values(&values) {}
+
+    std::string_view _name;
+    Values const* _values;
 };
 
+/**
+ * Forward iterator over the entries of a PropertySet; see PropertySet::entries.
+ *
+ * Nested PropertySets are walked with a stack of map positions, the last
+ * of an array of sets only, as by PropertySet::names.
+ */
+class PropertySet::EntryIterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Entry value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Entry const* pointer;
+    typedef Entry reference;
+
+    /// Construct a past-the-end iterator
+    EntryIterator() noexcept : _map(nullptr), _ordered(nullptr), _recursive(false) {}
+
+    Entry operator*() const noexcept;
+
+    EntryIterator& operator++();
+
+    EntryIterator operator++(int) {
+        EntryIterator old = *this;
+        ++*this;
+        return old;
+    }
+
+    friend bool operator==(EntryIterator const& a, EntryIterator const& b) noexcept {
+        if (a._atEnd() || b._atEnd()) {
+            return a._atEnd() == b._atEnd();
+        }
+        return a._ordered ? a._next == b._next
+                          : a._top.current == b._top.current && a._parents.size() == b._parents.size();
+    }
+    friend bool operator!=(EntryIterator const& a, EntryIterator const& b) noexcept { return !(a == b); }
+
+private:
+    friend class PropertySet;
+
+    // A position in the map of one set, whose names are prefixed by the
+    // first prefix characters of _path
+    struct Frame {
+        AnyMap::const_iterator current;
+        AnyMap::const_iterator end;
+        std::size_t prefix;
+    };
+
+    EntryIterator(PropertySet const& set, bool topLevelOnly);
+
+    bool _atEnd() const noexcept { return _ordered ? _next == _ordered->end() : _top.current == _top.end; }
+
+    // Move past finished maps, then write the name of the current entry to _path
+    void _settle();
+
+    Frame _top;
+    std::vector<Frame> _parents;  // Enclosing maps, outermost first; recursive only
+    std::string _path;            // Name of the current entry, if nested
+    AnyMap const* _map;           // Map looked up in order of _ordered
+    std::list<std::string> const* _ordered;
+    std::list<std::string>::const_iterator _next;
+    bool _recursive;
+};
+
+/// The entries of a PropertySet, for range-based for loops; see PropertySet::entries
+class PropertySet::EntryRange {
+public:
+    EntryIterator begin() const { return EntryIterator(*_set, _topLevelOnly); }
+    EntryIterator end() const noexcept { return EntryIterator(); }
+
+private:
+    friend class PropertySet;
+
+    EntryRange(PropertySet const& set, bool topLevelOnly) noexcept : _set(&set), _topLevelOnly(topLevelOnly) {}
+
+    PropertySet const* _set;
+    bool _topLevelOnly;
+};
+
+/**
+ * A read-only view of string values, in place and without copying.
+ *
+ * A single short string is not stored as a std::string, so the elements
+ * are presented as std::string_view.  A view is invalidated by any
+ * modification of the PropertySet it came from.
+ */
+template <>
+class PropertySet::ArrayView<std::string> {
+public:
+    typedef std::string_view value_type;
+
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string_view value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::string_view const* pointer;
+        typedef std::string_view reference;
+
+        const_iterator() noexcept : _strings(nullptr), _index(0) {}
+
+        std::string_view operator*() const noexcept {
+            return _strings ? std::string_view(_strings[_index]) : _single;
+        }
+
+        const_iterator& operator++() noexcept {
+            ++_index;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept {
+            const_iterator old = *this;
+            ++_index;
+            return old;
+        }
+
+        friend bool operator==(const_iterator const& a, const_iterator const& b) noexcept {
+            return a._index == b._index;
+        }
+        friend bool operator!=(const_iterator const& a, const_iterator const& b) noexcept {
+            return a._index != b._index;
+        }
+
+    private:
+        friend class ArrayView;
+
+        const_iterator(std::string const* strings, std::string_view single, std::size_t index) noexcept
+                : _strings(strings), _single(single), _index(index) {}
+
+        std::string const* _strings;
+        std::string_view _single;
+        std::size_t _index;
+    };
+    typedef const_iterator iterator;
+
+    ArrayView() noexcept : _strings(nullptr), _size(0) {}
+    ArrayView(std::string const* strings, std::size_t size) noexcept : _strings(strings), _size(size) {}
+
+    /// View a single string that is not held in a std::string
+    explicit ArrayView(std::string_view single) noexcept : _strings(nullptr), _single(single), _size(1) {}
+
+    std::size_t size() const noexcept { return _size; }
+    bool empty() const noexcept { return _size == 0; }
+
+    std::string_view operator[](std::size_t i) const noexcept {
+        return _strings ? std::string_view(_strings[i]) : _single;
+    }
+    std::string_view front() const noexcept { return (*this)[0]; }
+    std::string_view back() const noexcept { return (*this)[_size - 1]; }
+
+    const_iterator begin() const noexcept { return const_iterator(_strings, _single, 0); }
+    const_iterator end() const noexcept { return const_iterator(_strings, _single, _size); }
+
+private:
+    std::string const* _strings;
+    std::string_view _single;
+    std::size_t _size;
+};
+
+template <typename Visitor>
+void PropertySet::visitAll(Visitor&& visitor, bool topLevelOnly) const {
+    for (Entry const& entry : entries(topLevelOnly)) {
+        std::string_view const name = entry.getName();
+        entry.visit([&visitor, name](auto const& values) { visitor(name, values); });
+    }
+}
+
 
 std::ostream &operator<<(std::ostream &os, PropertySet const &propertySet);
 
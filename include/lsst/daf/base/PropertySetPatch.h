@@ -0,0 +1,149 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_PROPERTYSETPATCH_H
+#define LSST_DAF_BASE_PROPERTYSETPATCH_H
+
+/** @class lsst::daf::base::PropertySetPatch
+ * @brief The differences between two PropertySets or PropertyLists, as an
+ * edit script that turns the first into the second.
+ *
+ * Made by diff and applied by PropertySet::apply.  Names in the script are
+ * fully qualified.  A nested PropertySet present on both sides is compared
+ * name by name, while one present on only one side is a single edit, so the
+ * script grows with the differences rather than with the sets, and making
+ * it takes time linear in their sizes.  Values are compared exactly, except
+ * that NaNs equal each other; an array differing in any element is replaced
+ * whole.  Between two PropertyLists a changed comment is also a change, and
+ * the new order of the names is recorded if applying the edits would not
+ * reproduce it.
+ *
+ * A patch can be serialized to a compact byte string, to be shipped or
+ * stored instead of the whole set, and read back with deserialize.
+ *
+ * @ingroup daf_base
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lsst/base.h"
+#include "lsst/daf/base/PropertySet.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+class LSST_EXPORT PropertySetPatch {
+public:
+    /// One step of the edit script
+    struct Edit {
+        enum class Kind : std::uint8_t {
+            Add,     ///< Name is new; see getValues for its values
+            Remove,  ///< Name and everything below it are removed
+            Change,  ///< Values or comment replaced; see getValues for the values
+        };
+
+        Kind kind;
+        std::string name;     ///< Fully qualified property name
+        std::string comment;  ///< New comment if the target is a PropertyList; empty otherwise
+    };
+
+    /// Construct an empty patch, which changes nothing
+    PropertySetPatch();
+
+    PropertySetPatch(PropertySetPatch const&);
+    PropertySetPatch(PropertySetPatch&&) noexcept;
+    PropertySetPatch& operator=(PropertySetPatch const&);
+    PropertySetPatch& operator=(PropertySetPatch&&) noexcept;
+    ~PropertySetPatch() noexcept;
+
+    /**
+     * Compute the edits that turn one PropertySet into another.
+     *
+     * @param[in] from Original PropertySet or PropertyList.
+     * @param[in] to Modified PropertySet or PropertyList.
+     * @return Patch such that applying it to a copy of @a from gives a copy of @a to.
+     */
+    static PropertySetPatch diff(PropertySet const& from, PropertySet const& to);
+
+    /// Whether the patch changes nothing
+    bool empty() const noexcept { return _edits.empty() && _order.empty(); }
+
+    /// The edits, removals first, then additions and changes in the order of the target
+    std::vector<Edit> const& getEdits() const noexcept { return _edits; }
+
+    /**
+     * The new values of the added and changed names, in a flat PropertySet
+     * keyed by the fully qualified names of the edits.
+     */
+    PropertySet const& getValues() const noexcept { return *_values; }
+
+    /// The order of the names of the target PropertyList if it must be restored, else empty
+    std::vector<std::string> const& getOrder() const noexcept { return _order; }
+
+    /**
+     * Encode the patch as a compact, portable byte string.
+     *
+     * @throws TypeError The patch holds Persistable values, which cannot be serialized.
+     */
+    std::string serialize() const;
+
+    /**
+     * Decode a patch encoded by serialize.
+     *
+     * @param[in] bytes Encoded patch.
+     * @throws InvalidParameterError The bytes are not a valid encoded patch.
+     */
+    static PropertySetPatch deserialize(std::string_view bytes);
+
+private:
+    typedef PropertySet::Values Values;
+
+    // Append the edits between two sets, whose names are below prefix
+    void _diff(std::string const& prefix, PropertySet const& from, PropertySet const& to);
+
+    // Append an added or changed name, holding a deep copy of its values
+    void _addEdit(Edit::Kind kind, std::string name, Values const& values, std::string comment);
+
+    // Encode values or a nested set
+    static void _writeValues(std::string& out, Values const& values);
+    static void _writeSet(std::string& out, PropertySet const& set);
+
+    // Decode values or a nested set, which is depth levels below the patch
+    static Values _readValues(std::string_view& in, int depth);
+    static std::shared_ptr<PropertySet> _readSet(std::string_view& in, int depth);
+
+    std::vector<Edit> _edits;
+    std::shared_ptr<PropertySet> _values;  // Flat; never modified once the patch is made
+    std::vector<std::string> _order;
+};
+
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_PROPERTYSETPATCH_H
@@ -0,0 +1,206 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_PROPERTYSETSNAPSHOT_H
+#define LSST_DAF_BASE_PROPERTYSETSNAPSHOT_H
+
+/** @class lsst::daf::base::PropertySetSnapshot
+ * @brief A read-only view of a PropertySet or PropertyList as it was when
+ * the view was taken.
+ *
+ * Made by PropertySet::snapshot.  The snapshot shares the storage of every
+ * PropertySet in the tree rather than copying it, so taking one costs time
+ * proportional to the number of nested PropertySets, not the number of
+ * values; for a PropertyList or a flat PropertySet it is constant.  When the
+ * original is next modified, only the storage being modified is copied, and
+ * old versions are freed when the last snapshot sharing them is destroyed.
+ *
+ * The snapshot must be taken by the thread that modifies the original, but
+ * may then be read from any number of threads while that thread goes on
+ * modifying the original.
+ *
+ * @ingroup daf_base
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include "lsst/base.h"
+#include "lsst/daf/base/PropertySet.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+class LSST_EXPORT PropertySetSnapshot {
+public:
+    ~PropertySetSnapshot() noexcept;
+
+    // No copying; share the pointer instead
+    PropertySetSnapshot(PropertySetSnapshot const&) = delete;
+    PropertySetSnapshot& operator=(PropertySetSnapshot const&) = delete;
+
+    /// Make a modifiable deep copy; a PropertyList if the snapshot was taken of one
+    std::shared_ptr<PropertySet> thaw() const;
+
+    /// Whether the snapshot was taken of a PropertyList
+    bool isPropertyList() const noexcept { return _isList; }
+
+    /**
+     * Get the number of names, optionally including those in subproperties.
+     *
+     * @param[in] topLevelOnly If true (default) omit names from subproperties.
+     */
+    std::size_t nameCount(bool topLevelOnly = true) const;
+
+    /// Get the names, optionally including those in subproperties; see PropertySet::names
+    std::vector<std::string> names(bool topLevelOnly = true) const;
+
+    /// Determine if a name (possibly hierarchical) exists
+    bool exists(std::string_view name) const { return _lookup(name) != nullptr; }
+
+    /// Determine if a name (possibly hierarchical) has multiple values
+    bool isArray(std::string_view name) const;
+
+    /// Determine if a name (possibly hierarchical) is a subproperty
+    bool isPropertySetPtr(std::string_view name) const;
+
+    /// Number of values for a name (possibly hierarchical), or 0 if it does not exist
+    std::size_t valueCount(std::string_view name) const;
+
+    /**
+     * Get the type of a name (possibly hierarchical).
+     *
+     * @throws NotFoundError Property does not exist.
+     */
+    std::type_info const& typeOf(std::string_view name) const;
+
+    /**
+     * Get the last value for a property name (possibly hierarchical).
+     *
+     * @param[in] name Property name to examine, possibly hierarchical.
+     * @return Last value; for PropertySets, a deep copy as of the snapshot.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    T get(std::string_view name) const;
+
+    /**
+     * Get the last value for a property name (possibly hierarchical),
+     * returning the default if it does not exist.
+     *
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    T get(std::string_view name, T const& defaultValue) const;
+
+    /**
+     * Get the vector of values for a property name (possibly hierarchical).
+     *
+     * @return Values; for PropertySets, deep copies as of the snapshot.
+     * @throws NotFoundError Property does not exist.
+     * @throws TypeError Value does not match desired type.
+     */
+    template <typename T>
+    std::vector<T> getArray(std::string_view name) const;
+
+    /**
+     * Get the names in the order they were added to the PropertyList.
+     *
+     * @throws LogicError The snapshot was not taken of a PropertyList.
+     */
+    std::vector<std::string> getOrderedNames() const;
+
+    /**
+     * Get the comment for a name.
+     *
+     * @throws LogicError The snapshot was not taken of a PropertyList.
+     * @throws NotFoundError Property does not exist.
+     */
+    std::string const& getComment(std::string const& name) const;
+
+private:
+    friend class PropertySet;
+
+    typedef PropertySet::Values Values;
+    typedef PropertySet::AnyMap AnyMap;
+
+    // The storage of one PropertySet in the tree, shared with it
+    struct Node {
+        detail::CopyOnWrite<AnyMap> map;
+        bool flat;
+        std::uint64_t fingerprint;  // PropertySet::_fingerprint and _nestedCount when shared
+        std::size_t nestedCount;
+    };
+
+    /*
+     * Share the storage of a PropertySet and of every PropertySet it contains.
+     *
+     * @param[in] root PropertySet to take a snapshot of.
+     */
+    explicit PropertySetSnapshot(PropertySet const& root);
+
+    // Add the nodes for set and everything below it, if not already present
+    void _share(PropertySet const& set);
+
+    // The node for a PropertySet in the tree
+    Node const& _node(PropertySet const* set) const;
+
+    // The values for a name, or null if it does not exist
+    Values const* _lookup(std::string_view name) const;
+
+    // The values for a name; throws NotFoundError if it does not exist
+    Values const& _at(std::string_view name) const;
+
+    void _names(Node const& node, std::string const& prefix, bool topLevelOnly,
+                std::vector<std::string>& names) const;
+
+    // The number of names in node and the sets below it
+    std::size_t _nameCount(Node const& node) const;
+
+    // A new PropertySet holding a deep copy of node
+    std::shared_ptr<PropertySet> _thaw(Node const& node) const;
+
+    // The nested PropertySet held by values, which must hold PropertySets, or null
+    static PropertySet const* _child(Values const& values);
+
+    Node _root;
+    std::unordered_map<PropertySet const*, Node> _nodes;  // Nested sets, keyed by the originals
+    bool _isList;
+    detail::CopyOnWrite<detail::FlatMap<std::string>> _comments;  // PropertyList only
+    detail::CopyOnWrite<std::list<std::string>> _order;           // PropertyList only
+};
+
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_PROPERTYSETSNAPSHOT_H
@@ -0,0 +1,125 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_DETAIL_COPYONWRITE_H
+#define LSST_DAF_BASE_DETAIL_COPYONWRITE_H
+
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace lsst {
+namespace daf {
+namespace base {
+namespace detail {
+
+/**
+ * A value of type T whose copies share storage until one of them is modified.
+ *
+ * Reading goes through operator* and operator->, which only give const
+ * access; modifying requires write(), which first makes a private copy if
+ * the storage is shared.  As with the containers it wraps, an object may be
+ * read from several threads at once but must not be modified concurrently.
+ * Copies may be read on other threads while the original is modified.
+ *
+ * Storage is allocated from a memory resource, or with operator new if none
+ * is given; a T that can be constructed from the resource is given it too.
+ * Copies share the resource along with the storage.
+ */
+template <typename T>
+class CopyOnWrite {
+public:
+    /// Construct a default value; no storage is allocated until the first write
+    CopyOnWrite() noexcept = default;
+
+    /// Construct a default value whose storage will come from resource
+    explicit CopyOnWrite(std::pmr::memory_resource* resource) noexcept : _resource(resource) {}
+
+    CopyOnWrite(CopyOnWrite const&) = default;
+    CopyOnWrite& operator=(CopyOnWrite const&) = default;
+
+    /// Moved-from objects hold a default value
+    CopyOnWrite(CopyOnWrite&&) noexcept = default;
+    CopyOnWrite& operator=(CopyOnWrite&&) noexcept = default;
+
+    ~CopyOnWrite() = default;
+
+    T const& operator*() const noexcept { return _ptr ? *_ptr : _empty(); }
+    T const* operator->() const noexcept { return &**this; }
+
+    /// Get modifiable access, copying the value first if it is shared
+    T& write() {
+        if (!_ptr) {
+            if constexpr (std::is_constructible<T, std::pmr::memory_resource*>::value) {
+                _ptr = _make(_resource);
+            } else {
+                _ptr = _make();
+            }
+        } else if (_ptr.use_count() > 1) {
+            _ptr = _make(*_ptr);
+        } else {
+            // Order our writes after the reads of a copy just released on another thread
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *_ptr;
+    }
+
+    /// Replace the value, without copying the old one
+    void reset(T value) { _ptr = _make(std::move(value)); }
+
+    /// Replace the value with a default value, releasing the storage
+    void reset() noexcept { _ptr.reset(); }
+
+    /// Whether the storage is shared with another copy
+    bool isShared() const noexcept { return _ptr.use_count() > 1; }
+
+    /// The memory resource, or null for operator new
+    std::pmr::memory_resource* getResource() const noexcept { return _resource; }
+
+private:
+    template <typename... Args>
+    std::shared_ptr<T> _make(Args&&... args) const {
+        if (_resource) {
+            return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(_resource),
+                                           std::forward<Args>(args)...);
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+
+    static T const& _empty() noexcept {
+        static T const empty;
+        return empty;
+    }
+
+    std::shared_ptr<T> _ptr;
+    std::pmr::memory_resource* _resource = nullptr;
+};
+
+}  // namespace detail
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_DETAIL_COPYONWRITE_H
@@ -0,0 +1,72 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_DETAIL_FINGERPRINT_H
+#define LSST_DAF_BASE_DETAIL_FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace lsst {
+namespace daf {
+namespace base {
+namespace detail {
+
+/*
+ * Building blocks of PropertySet::fingerprint.  Fingerprints are persistent
+ * cache keys, so these must give the same results in every process and on
+ * every platform; changing them changes every fingerprint.
+ */
+
+/// Scramble 64 bits, with every input bit affecting every output bit (the splitmix64 finalizer)
+inline std::uint64_t fingerprintMix(std::uint64_t x) noexcept {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/// Hash a string of bytes, eight at a time, independently of byte order and alignment
+inline std::uint64_t fingerprintBytes(std::uint64_t seed, std::string_view bytes) noexcept {
+    std::uint64_t h = fingerprintMix(seed ^ bytes.size());
+    std::size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8) {
+        std::uint64_t word = 0;
+        for (std::size_t k = 0; k < 8; ++k) {
+            word |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[i + k])) << (8 * k);
+        }
+        h = fingerprintMix(h ^ word) + 0x9E3779B97F4A7C15ULL;
+    }
+    std::uint64_t tail = 0;
+    for (std::size_t k = 0; i + k < bytes.size(); ++k) {
+        tail |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[i + k])) << (8 * k);
+    }
+    return fingerprintMix(h ^ tail);
+}
+
+}  // namespace detail
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_DETAIL_FINGERPRINT_H
@@ -0,0 +1,460 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_DETAIL_FLATMAP_H
+#define LSST_DAF_BASE_DETAIL_FLATMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "lsst/daf/base/detail/Name.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+namespace detail {
+
+/**
+ * Open-addressing hash map from names to values, used to hold the entries
+ * of a PropertySet.
+ *
+ * Entries are stored in one contiguous array, with their hashes in a parallel
+ * array, so a probe compares hashes without touching any key.  Collisions are
+ * resolved by linear probing, and erasure shifts later entries back instead of
+ * leaving tombstones.  Lookup takes a std::string_view, so looking up a
+ * `std::string` or `char const*` never allocates.
+ *
+ * Unlike std::unordered_map, any insertion or erasure may move other entries,
+ * so it invalidates all iterators and references into the map.
+ *
+ * The arrays and the names' storage come from the map's memory resource, or
+ * from operator new if it has none.  Copies use the same resource.
+ */
+template <typename V>
+class FlatMap {
+public:
+    typedef Name key_type;
+    typedef V mapped_type;
+    typedef std::pair<Name, V> value_type;
+    typedef std::size_t size_type;
+
+    template <bool isConst>
+    class Iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename FlatMap::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::conditional_t<isConst, value_type const, value_type>* pointer;
+        typedef std::conditional_t<isConst, value_type const, value_type>& reference;
+
+        Iterator() noexcept = default;
+
+        // Allow conversion from iterator to const_iterator
+        template <bool otherConst, typename = std::enable_if_t<isConst && !otherConst>>
+        Iterator(Iterator<otherConst> const& other) noexcept
+                : _entry(other._entry), _hash(other._hash), _end(other._end) {}
+
+        reference operator*() const noexcept { return *_entry; }
+        pointer operator->() const noexcept { return _entry; }
+
+        Iterator& operator++() noexcept {
+            ++_entry;
+            ++_hash;
+            _skipEmpty();
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            Iterator result(*this);
+            ++(*this);
+            return result;
+        }
+
+        template <bool otherConst>
+        bool operator==(Iterator<otherConst> const& other) const noexcept {
+            return _entry == other._entry;
+        }
+
+        template <bool otherConst>
+        bool operator!=(Iterator<otherConst> const& other) const noexcept {
+            return _entry != other._entry;
+        }
+
+    private:
+        friend class FlatMap;
+        template <bool>
+        friend class Iterator;
+
+        Iterator(pointer entry, std::size_t const* hash, std::size_t const* end) noexcept
+                : _entry(entry), _hash(hash), _end(end) {}
+
+        void _skipEmpty() noexcept {
+            while (_hash != _end && *_hash == EMPTY) {
+                ++_entry;
+                ++_hash;
+            }
+        }
+
+        pointer _entry = nullptr;
+        std::size_t const* _hash = nullptr;
+        std::size_t const* _end = nullptr;
+    };
+
+    typedef Iterator<false> iterator;
+    typedef Iterator<true> const_iterator;
+
+    FlatMap() noexcept = default;
+
+    explicit FlatMap(std::pmr::memory_resource* resource) noexcept : _resource(resource) {}
+
+    FlatMap(FlatMap const& other) : FlatMap(other._resource) {
+        if (other._size == 0) return;
+        _allocate(other._capacity);
+        try {
+            // Same capacity, so every entry can stay in the same slot
+            for (std::size_t i = 0; i < _capacity; ++i) {
+                if (other._hashes[i] != EMPTY) {
+                    new (_entries + i) value_type(other._entries[i]);
+                    _hashes[i] = other._hashes[i];
+                    ++_size;
+                }
+            }
+        } catch (...) {
+            _release();
+            throw;
+        }
+    }
+
+    FlatMap(FlatMap&& other) noexcept { _swap(other); }
+
+    FlatMap& operator=(FlatMap const& other) {
+        if (this != &other) {
+            FlatMap copy(other);
+            _swap(copy);
+        }
+        return *this;
+    }
+
+    FlatMap& operator=(FlatMap&& other) noexcept {
+        if (this != &other) {
+            _release();
+            _swap(other);
+        }
+        return *this;
+    }
+
+    ~FlatMap() noexcept { _release(); }
+
+    iterator begin() noexcept { return _makeIterator(0); }
+    const_iterator begin() const noexcept { return _makeIterator(0); }
+    iterator end() noexcept { return iterator(_entries + _capacity, _hashes + _capacity, _hashes + _capacity); }
+    const_iterator end() const noexcept {
+        return const_iterator(_entries + _capacity, _hashes + _capacity, _hashes + _capacity);
+    }
+
+    bool empty() const noexcept { return _size == 0; }
+    size_type size() const noexcept { return _size; }
+
+    /// The memory resource, or null for operator new
+    std::pmr::memory_resource* getResource() const noexcept { return _resource; }
+
+    /// Number of slots; the map grows when it would become more than 3/4 full
+    size_type capacity() const noexcept { return _capacity; }
+
+    /// Make room for at least n entries without further rehashing
+    void reserve(size_type n) {
+        std::size_t capacity = MIN_CAPACITY;
+        while (capacity * MAX_LOAD_NUM < n * MAX_LOAD_DEN) {
+            capacity *= 2;
+        }
+        if (capacity > _capacity) {
+            _rehash(capacity);
+        }
+    }
+
+    void clear() noexcept {
+        for (std::size_t i = 0; i < _capacity; ++i) {
+            if (_hashes[i] != EMPTY) {
+                _entries[i].~value_type();
+                _hashes[i] = EMPTY;
+            }
+        }
+        _size = 0;
+    }
+
+    iterator find(std::string_view key) noexcept {
+        std::size_t const i = _lookup(key, hash(key));
+        return i == NPOS ? end() : _makeIterator(i);
+    }
+
+    const_iterator find(std::string_view key) const noexcept {
+        std::size_t const i = _lookup(key, hash(key));
+        return i == NPOS ? end() : _makeIterator(i);
+    }
+
+    /// Find `key`, using its precomputed hash and atom if it is interned
+    iterator find(Name const& key) noexcept {
+        std::size_t const i = _lookup(key, hash(key));
+        return i == NPOS ? end() : _makeIterator(i);
+    }
+
+    const_iterator find(Name const& key) const noexcept {
+        std::size_t const i = _lookup(key, hash(key));
+        return i == NPOS ? end() : _makeIterator(i);
+    }
+
+    /// Find `key` given its precomputed hash(key)
+    iterator find(std::string_view key, std::size_t keyHash) noexcept {
+        std::size_t const i = _lookup(key, keyHash);
+        return i == NPOS ? end() : _makeIterator(i);
+    }
+
+    const_iterator find(std::string_view key, std::size_t keyHash) const noexcept {
+        std::size_t const i = _lookup(key, keyHash);
+        return i == NPOS ? end() : _makeIterator(i);
+    }
+
+    size_type count(std::string_view key) const noexcept { return _lookup(key, hash(key)) == NPOS ? 0 : 1; }
+
+    /**
+     * Insert an entry constructed from `args` if `key` is not present.
+     *
+     * @return Iterator to the entry for `key`, and whether it was inserted.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(std::string_view key, Args&&... args) {
+        return _tryEmplace(key, hash(key), std::forward<Args>(args)...);
+    }
+
+    /// As try_emplace(std::string_view, ...), but reusing `key` (and its atom, if interned)
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(Name const& key, Args&&... args) {
+        return _tryEmplace(key, hash(key), std::forward<Args>(args)...);
+    }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplace(K const& key, Args&&... args) {
+        return try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    /// Insert `value` for `key`, or assign it if `key` is already present
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(std::string_view key, M&& value) {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    /// Remove the entry for `key`, if any; return the number of entries removed
+    size_type erase(std::string_view key) noexcept {
+        std::size_t const i = _lookup(key, hash(key));
+        if (i == NPOS) {
+            return 0;
+        }
+        _eraseSlot(i);
+        return 1;
+    }
+
+    /// Hash of a key as stored in the map; never zero
+    static std::size_t hash(std::string_view key) noexcept {
+        std::size_t const h = std::hash<std::string_view>()(key);
+        return h == EMPTY ? 1 : h;
+    }
+
+    static std::size_t hash(Name const& key) noexcept {
+        std::size_t const h = key.hash();
+        return h == EMPTY ? 1 : h;
+    }
+
+private:
+    static constexpr std::size_t EMPTY = 0;
+    static constexpr std::size_t NPOS = static_cast<std::size_t>(-1);
+    static constexpr std::size_t MIN_CAPACITY = 8;
+    static constexpr std::size_t MAX_LOAD_NUM = 3;
+    static constexpr std::size_t MAX_LOAD_DEN = 4;
+
+    iterator _makeIterator(std::size_t i) noexcept {
+        iterator result(_entries + i, _hashes + i, _hashes + _capacity);
+        result._skipEmpty();
+        return result;
+    }
+
+    const_iterator _makeIterator(std::size_t i) const noexcept {
+        const_iterator result(_entries + i, _hashes + i, _hashes + _capacity);
+        result._skipEmpty();
+        return result;
+    }
+
+    // Preferred slot of a hash: Fibonacci hashing spreads all bits of the hash over the index
+    std::size_t _home(std::size_t h) const noexcept {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(h) * 0x9E3779B97F4A7C15ULL) >> _shift);
+    }
+
+    template <typename K>
+    std::size_t _lookup(K const& key, std::size_t h) const noexcept {
+        if (_size == 0) {
+            return NPOS;
+        }
+        for (std::size_t i = _home(h);; i = (i + 1) & (_capacity - 1)) {
+            if (_hashes[i] == EMPTY) {
+                return NPOS;
+            }
+            if (_hashes[i] == h && _entries[i].first == key) {
+                return i;
+            }
+        }
+    }
+
+    // Insert an entry for key, which is a Name or something a Name can be made from
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> _tryEmplace(K const& key, std::size_t h, Args&&... args) {
+        std::size_t i = _lookup(key, h);
+        if (i != NPOS) {
+            return {_makeIterator(i), false};
+        }
+        if ((_size + 1) * MAX_LOAD_DEN > _capacity * MAX_LOAD_NUM) {
+            _rehash(_capacity == 0 ? MIN_CAPACITY : 2 * _capacity);
+        }
+        i = _home(h);
+        while (_hashes[i] != EMPTY) {
+            i = (i + 1) & (_capacity - 1);
+        }
+        new (_entries + i) value_type(std::piecewise_construct, std::forward_as_tuple(key, _resource),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+        _hashes[i] = h;
+        ++_size;
+        return {_makeIterator(i), true};
+    }
+
+    void _eraseSlot(std::size_t i) noexcept {
+        _entries[i].~value_type();
+        _hashes[i] = EMPTY;
+        --_size;
+        // Shift back later entries of the probe sequence that could live in the hole
+        std::size_t const mask = _capacity - 1;
+        for (std::size_t j = (i + 1) & mask; _hashes[j] != EMPTY; j = (j + 1) & mask) {
+            std::size_t const home = _home(_hashes[j]);
+            // Move j into the hole at i unless its home lies cyclically in (i, j]
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                new (_entries + i) value_type(std::move(_entries[j]));
+                _hashes[i] = _hashes[j];
+                _entries[j].~value_type();
+                _hashes[j] = EMPTY;
+                i = j;
+            }
+        }
+    }
+
+    void* _allocateBytes(std::size_t bytes, std::size_t alignment) {
+        return _resource ? _resource->allocate(bytes, alignment) : ::operator new(bytes);
+    }
+
+    void _deallocateBytes(void* p, std::size_t bytes, std::size_t alignment) noexcept {
+        if (_resource) {
+            _resource->deallocate(p, bytes, alignment);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    void _allocate(std::size_t capacity) {
+        _hashes = static_cast<std::size_t*>(
+                _allocateBytes(capacity * sizeof(std::size_t), alignof(std::size_t)));
+        std::fill_n(_hashes, capacity, EMPTY);
+        try {
+            _entries = static_cast<value_type*>(
+                    _allocateBytes(capacity * sizeof(value_type), alignof(value_type)));
+        } catch (...) {
+            _deallocateBytes(_hashes, capacity * sizeof(std::size_t), alignof(std::size_t));
+            _hashes = nullptr;
+            throw;
+        }
+        _capacity = capacity;
+        _shift = 64;
+        for (std::size_t c = capacity; c > 1; c >>= 1) {
+            --_shift;
+        }
+    }
+
+    void _rehash(std::size_t capacity) {
+        FlatMap grown(_resource);
+        grown._allocate(capacity);
+        for (std::size_t i = 0; i < _capacity; ++i) {
+            if (_hashes[i] != EMPTY) {
+                std::size_t j = grown._home(_hashes[i]);
+                while (grown._hashes[j] != EMPTY) {
+                    j = (j + 1) & (capacity - 1);
+                }
+                new (grown._entries + j) value_type(std::move_if_noexcept(_entries[i]));
+                grown._hashes[j] = _hashes[i];
+                ++grown._size;
+            }
+        }
+        _swap(grown);
+    }
+
+    void _release() noexcept {
+        if (_capacity == 0) return;
+        clear();
+        _deallocateBytes(_entries, _capacity * sizeof(value_type), alignof(value_type));
+        _deallocateBytes(_hashes, _capacity * sizeof(std::size_t), alignof(std::size_t));
+        _entries = nullptr;
+        _hashes = nullptr;
+        _capacity = 0;
+    }
+
+    void _swap(FlatMap& other) noexcept {
+        std::swap(_entries, other._entries);
+        std::swap(_hashes, other._hashes);
+        std::swap(_capacity, other._capacity);
+        std::swap(_size, other._size);
+        std::swap(_shift, other._shift);
+        std::swap(_resource, other._resource);
+    }
+
+    value_type* _entries = nullptr;
+    std::size_t* _hashes = nullptr;
+    std::size_t _capacity = 0;
+    std::size_t _size = 0;
+    unsigned _shift = 64;
+    std::pmr::memory_resource* _resource = nullptr;
+};
+
+}  // namespace detail
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_DETAIL_FLATMAP_H
@@ -0,0 +1,147 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_DETAIL_NAME_H
+#define LSST_DAF_BASE_DETAIL_NAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "lsst/base.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+namespace detail {
+
+/**
+ * A property name as stored in the containers of a PropertySet or PropertyList.
+ *
+ * A Name either owns its characters (inline for names of up to 16 characters)
+ * or refers to an atom in a process-wide intern table.  Interned names are
+ * never freed; they carry a precomputed hash and two interned names are equal
+ * exactly when they refer to the same atom.
+ *
+ * Interning is off by default; turn it on with setInterning when many
+ * containers share the same names.  Names created while it is off stay
+ * owned, and owned and interned names compare equal when their characters do.
+ *
+ * Owned names too long to be stored inline are allocated from a memory
+ * resource, or with operator new if none is given.
+ */
+class LSST_EXPORT Name {
+public:
+    /// Atom of a name that is not interned
+    static constexpr std::uint32_t NO_ATOM = 0xFFFFFFFF;
+
+    /// Make a name, interned if interning is enabled
+    explicit Name(std::string_view name, std::pmr::memory_resource* resource = nullptr);
+
+    /// Copy a name, allocating from resource if the copy needs storage
+    Name(Name const& other, std::pmr::memory_resource* resource);
+
+    /// Make an interned name, regardless of whether interning is enabled
+    static Name intern(std::string_view name);
+
+    Name(Name const& other);
+    Name(Name&& other) noexcept;
+    Name& operator=(Name const& other);
+    Name& operator=(Name&& other) noexcept;
+    ~Name() noexcept;
+
+    std::string_view view() const noexcept {
+        return std::string_view(_kind == INLINE ? _inline : _chars, _size);
+    }
+
+    std::string str() const { return std::string(view()); }
+
+    bool isInterned() const noexcept { return _kind == INTERNED; }
+
+    /// Index of the atom in the intern table, or NO_ATOM
+    std::uint32_t getAtom() const noexcept { return _kind == INTERNED ? _header()->atom : NO_ATOM; }
+
+    /// Same as std::hash<std::string_view>()(view()); precomputed for interned names
+    std::size_t hash() const noexcept {
+        return _kind == INTERNED ? _header()->hash : std::hash<std::string_view>()(view());
+    }
+
+    friend bool operator==(Name const& a, Name const& b) noexcept {
+        if (a._kind == INTERNED && b._kind == INTERNED) {
+            return a._chars == b._chars;
+        }
+        return a.view() == b.view();
+    }
+    friend bool operator!=(Name const& a, Name const& b) noexcept { return !(a == b); }
+    friend bool operator==(Name const& a, std::string_view b) noexcept { return a.view() == b; }
+    friend bool operator!=(Name const& a, std::string_view b) noexcept { return a.view() != b; }
+
+    friend std::ostream& operator<<(std::ostream& os, Name const& name) { return os << name.view(); }
+
+    /// Enable or disable interning of names created from now on, in all containers
+    static void setInterning(bool enable) noexcept;
+
+    /// Whether new names are interned
+    static bool isInterning() noexcept;
+
+    /// Number of atoms in the intern table
+    static std::size_t internedCount();
+
+    /// Header of an atom; the characters of the name follow it
+    struct AtomHeader {
+        std::size_t hash;
+        std::uint32_t atom;
+    };
+
+private:
+    enum Kind : std::uint8_t { INLINE, HEAP, INTERNED };
+    static constexpr std::size_t INLINE_SIZE = 16;
+
+    Name() noexcept = default;
+
+    AtomHeader const* _header() const noexcept {
+        return reinterpret_cast<AtomHeader const*>(_chars) - 1;
+    }
+
+    // Owned storage starts with the resource it came from, followed by the characters
+    void _assign(std::string_view name, std::pmr::memory_resource* resource);
+    void _release() noexcept;
+
+    union {
+        char _inline[INLINE_SIZE];
+        char const* _chars;  // Owned storage for HEAP, in the intern table for INTERNED
+    };
+    std::uint32_t _size = 0;
+    Kind _kind = INLINE;
+};
+
+}  // namespace detail
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_DETAIL_NAME_H
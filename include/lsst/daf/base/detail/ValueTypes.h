@@ -0,0 +1,96 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+#ifndef LSST_DAF_BASE_DETAIL_VALUETYPES_H
+#define LSST_DAF_BASE_DETAIL_VALUETYPES_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "lsst/daf/base/DateTime.h"
+#include "lsst/daf/base/Persistable.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+class PropertySet;
+
+namespace detail {
+
+/// The value types a PropertySet supports, in the order of PropertySet::Type.
+typedef std::tuple<bool, char, signed char, unsigned char, short, unsigned short, int, unsigned int, long,
+                   unsigned long, long long, unsigned long long, float, double, std::nullptr_t, std::string,
+                   std::shared_ptr<PropertySet>, Persistable::Ptr, DateTime>
+        ValueTypes;
+
+/// Position of T in ValueTypes.
+template <typename T, typename Types = ValueTypes>
+struct TypeIndex;
+
+template <typename T, typename First, typename... Rest>
+struct TypeIndex<T, std::tuple<First, Rest...>> {
+    static constexpr std::size_t value =
+            std::is_same<T, First>::value ? 0 : 1 + TypeIndex<T, std::tuple<Rest...>>::value;
+};
+
+template <typename T>
+struct TypeIndex<T, std::tuple<>> {
+    static constexpr std::size_t value = 0;
+};
+
+/// A type carried as a value, so that generic lambdas can be given one
+template <typename T>
+struct TypeIdentity {
+    typedef T type;
+};
+
+template <typename F, std::size_t... I>
+decltype(auto) _dispatch(std::size_t index, F&& f, std::index_sequence<I...>) {
+    typedef decltype(f(TypeIdentity<std::tuple_element_t<0, ValueTypes>>())) Result;
+    static constexpr Result (*table[])(F&&) = {[](F&& g) -> Result {
+        return g(TypeIdentity<std::tuple_element_t<I, ValueTypes>>());
+    }...};
+    return table[index](std::forward<F>(f));
+}
+
+/**
+ * Call f(TypeIdentity<T>()) for the index of T in ValueTypes, through a
+ * jump table.  f must return the same type for every T.
+ */
+template <typename F>
+decltype(auto) dispatch(std::size_t index, F&& f) {
+    return _dispatch(index, std::forward<F>(f), std::make_index_sequence<std::tuple_size<ValueTypes>::value>());
+}
+
+}  // namespace detail
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+#endif  // LSST_DAF_BASE_DETAIL_VALUETYPES_H
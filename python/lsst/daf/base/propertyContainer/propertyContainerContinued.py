@@ -24,7 +24,6 @@
 __all__ = ["getPropertySetState", "getPropertyListState", "setPropertySetState", "setPropertyListState"]
 
 import enum
-import math
 import numbers
 import dataclasses
 from collections.abc import Mapping, KeysView, ValuesView, ItemsView
@@ -175,12 +174,11 @@ def _propertyContainerElementTypeName(container, name):
     name : `str`
         Name of element
     """
-    try:
-        t = container.typeOf(name)
-    except LookupError as e:
+    t = container._typeOfOrNone(name)
+    if t is None:
         # KeyError is more commonly expected when asking for an element
         # from a mapping.
-        raise KeyError(str(e)) from None
+        raise KeyError(name + " not found")
 
     return _TYPE_MAP.get(t, None)
 
@@ -216,27 +214,26 @@ def _propertyContainerGet(container, name, returnStyle):
     ValueError
         Raised if the value for ``returnStyle`` is not correct.
     """
-    if not container.exists(name):
-        raise KeyError(name + " not found")
     if returnStyle not in ReturnStyle:
         raise ValueError("returnStyle {} must be a ReturnStyle".format(returnStyle))
 
-    elemType = _propertyContainerElementTypeName(container, name)
+    # Look the type up once; a missing name or an unexpected type must not
+    # cost a C++ exception.
+    t = container._typeOfOrNone(name)
+    if t is None:
+        raise KeyError(name + " not found")
+    elemType = _TYPE_MAP.get(t, None)
     if elemType and elemType != "PropertySet":
         value = getattr(container, "getArray" + elemType)(name)
         if returnStyle == ReturnStyle.ARRAY or (returnStyle == ReturnStyle.AUTO and len(value) > 1):
             return value
         return value[-1]
 
-    if container.isPropertySetPtr(name):
-        try:
-            return container.getAsPropertyListPtr(name)
-        except Exception:
-            return container.getAsPropertySetPtr(name)
-    try:
+    if elemType == "PropertySet":
+        # Returned as a PropertyList if it is one
+        return container.getAsPropertySetPtr(name)
+    if t == PropertySet.TYPE_Persistable:
         return container.getAsPersistablePtr(name)
-    except Exception:
-        pass
     raise TypeError('Unknown PropertySet value type for ' + name)
 
 
@@ -649,30 +646,6 @@ class PropertySet:
                 d[name] = v
         return d
 
-    def __eq__(self, other):
-        if type(self) is not type(other):
-            return NotImplemented
-
-        if len(self) != len(other):
-            return False
-
-        for name in self:
-            if (self_typeOf := self.typeOf(name)) != other.typeOf(name):
-                return False
-
-            if (v1 := _propertyContainerGet(self, name, returnStyle=ReturnStyle.AUTO)) != \
-                    (v2 := _propertyContainerGet(other, name, returnStyle=ReturnStyle.AUTO)):
-                # It is possible that we have floats that are NaN. When
-                # equating two PropertySets if there are fields with NaN
-                # these should equate equal.
-                if self_typeOf in (_TYPE_MAP["Float"], _TYPE_MAP["Double"]) \
-                        and math.isnan(v1) and math.isnan(v2):
-                    pass
-                else:
-                    return False
-
-        return True
-
     def __copy__(self):
         # Copy without having to go through pickle state
         ps = PropertySet()
@@ -1046,19 +1019,6 @@ class PropertyList:
     # For PropertyList the two are equivalent
     toDict = toOrderedDict
 
-    def __eq__(self, other):
-        # super() doesn't seem to work properly in @continueClass;
-        # note that super with arguments seems to work at first, but actually
-        # doesn't either.
-        if not PropertySet.__eq__(self, other):
-            return False
-
-        for name in self:
-            if self.getComment(name) != other.getComment(name):
-                return False
-
-        return True
-
     def __copy__(self):
         # Copy without having to go through pickle state
         pl = PropertyList()
@@ -17,9 +17,9 @@ namespace {
 template <typename T, typename C>
 void declareAccessors(C& cls, std::string const& name) {
     const std::string getName = "get" + name;
-    cls.def(getName.c_str(), (T (PropertyList::*)(std::string const&) const) & PropertyList::get<T>,
+    cls.def(getName.c_str(), (T (PropertyList::*)(std::string_view) const) & PropertyList::get<T>,
             "name"_a);
-    cls.def(getName.c_str(), (T (PropertyList::*)(std::string const&, T const&) const) & PropertyList::get<T>,
+    cls.def(getName.c_str(), (T (PropertyList::*)(std::string_view, T const&) const) & PropertyList::get<T>,
             "name"_a, "defaultValue"_a);
 
     // Warning: __len__ is ambiguous so do not attempt to define it. It could return
@@ -29,7 +29,7 @@ void declareAccessors(C& cls, std::string const& name) {
 
     const std::string getArrayName = "getArray" + name;
     cls.def(getArrayName.c_str(),
-            (std::vector<T> (PropertyList::*)(std::string const&) const) & PropertyList::getArray<T>,
+            (std::vector<T> (PropertyList::*)(std::string_view) const) & PropertyList::getArray<T>,
             "name"_a);
 
     const std::string setName = "set" + name;
@@ -67,6 +67,9 @@ void wrapPropertyList(lsst::cpputils::python::WrapperCollection &wrappers) {
         cls.def("getOrderedNames", &PropertyList::getOrderedNames);
         cls.def("deepCopy",
                 [](PropertyList const &self) { return std::static_pointer_cast<PropertySet>(self.deepCopy()); });
+        cls.def("fingerprint",
+                py::overload_cast<bool, bool>(&PropertyList::fingerprint, py::const_),
+                "withComments"_a = false, "withOrder"_a = false);
         declareAccessors<bool>(cls, "Bool");
         declareAccessors<short>(cls, "Short");
         declareAccessors<int>(cls, "Int");
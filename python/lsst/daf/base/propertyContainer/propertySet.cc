@@ -20,13 +20,13 @@ namespace {
 template <typename T, typename C>
 void declareAccessors(C& cls, std::string const& name) {
     const std::string getName = "get" + name;
-    cls.def(getName.c_str(), (T (PropertySet::*)(std::string const&) const) & PropertySet::get<T>, "name"_a);
-    cls.def(getName.c_str(), (T (PropertySet::*)(std::string const&, T const&) const) & PropertySet::get<T>,
+    cls.def(getName.c_str(), (T (PropertySet::*)(std::string_view) const) & PropertySet::get<T>, "name"_a);
+    cls.def(getName.c_str(), (T (PropertySet::*)(std::string_view, T const&) const) & PropertySet::get<T>,
             "name"_a, "defaultValue"_a);
 
     const std::string getArrayName = "getArray" + name;
     cls.def(getArrayName.c_str(),
-            (std::vector<T> (PropertySet::*)(std::string const&) const) & PropertySet::getArray<T>, "name"_a);
+            (std::vector<T> (PropertySet::*)(std::string_view) const) & PropertySet::getArray<T>, "name"_a);
 
     const std::string setName = "set" + name;
     cls.def(setName.c_str(), (void (PropertySet::*)(std::string const&, T const&)) & PropertySet::set<T>,
@@ -61,22 +61,33 @@ void declareAccessors(C& cls, std::string const& name) {
      using PyPropertySet = py::classh<PropertySet>;
      wrappers.wrapType(PyPropertySet(wrappers.module, "PropertySet"), [](auto &mod, auto &cls) {
          cls.def(py::init<bool>(), "flat"_a = false);
+         cls.def_static("setNameInterning", &PropertySet::setNameInterning, "enable"_a);
+         cls.def_static("getNameInterning", &PropertySet::getNameInterning);
 
          cls.def("deepCopy", &PropertySet::deepCopy);
+         // Compares PropertyLists too, through the virtual comparison in C++
+         cls.def("__eq__",
+                 [](PropertySet const &self, PropertySet const &other) { return self == other; },
+                 py::is_operator());
+         cls.def("__ne__",
+                 [](PropertySet const &self, PropertySet const &other) { return self != other; },
+                 py::is_operator());
+         cls.def("fingerprint", &PropertySet::fingerprint);
          cls.def("nameCount", &PropertySet::nameCount, "topLevelOnly"_a = true);
          cls.def("names", &PropertySet::names, "topLevelOnly"_a = true);
          cls.def("paramNames", &PropertySet::paramNames, "topLevelOnly"_a = true);
          cls.def("propertySetNames", &PropertySet::propertySetNames, "topLevelOnly"_a = true);
-         cls.def("exists", &PropertySet::exists);
+         cls.def("exists", py::overload_cast<std::string_view>(&PropertySet::exists, py::const_));
          cls.def("isArray", &PropertySet::isArray);
          cls.def("isUndefined", &PropertySet::isUndefined);
          cls.def("isPropertySetPtr", &PropertySet::isPropertySetPtr);
          cls.def("valueCount",
                  py::overload_cast<>(&PropertySet::valueCount, py::const_));
          cls.def("valueCount",
-                 py::overload_cast<std::string const &>(&PropertySet::valueCount,
-                                                        py::const_));
+                 py::overload_cast<std::string_view>(&PropertySet::valueCount, py::const_));
          cls.def("typeOf", &PropertySet::typeOf, py::return_value_policy::reference);
+         // Probes a name without raising, for the pure-Python accessors
+         cls.def("_typeOfOrNone", &PropertySet::tryTypeOf, py::return_value_policy::reference);
          cls.def("toString", &PropertySet::toString, "topLevelOnly"_a = false, "indent"_a = "");
          cls.def(
                  "copy",
@@ -111,6 +122,8 @@ void declareAccessors(C& cls, std::string const& name) {
          declareAccessors<std::string>(cls, "String");
          declareAccessors<DateTime>(cls, "DateTime");
          declareAccessors<std::shared_ptr<PropertySet>>(cls, "PropertySet");
+         cls.attr("TYPE_Persistable") =
+                 py::cast(PropertySet::typeOfT<Persistable::Ptr>(), py::return_value_policy::reference);
      });
 }
 
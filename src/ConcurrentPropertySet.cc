@@ -0,0 +1,222 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "lsst/daf/base/ConcurrentPropertySet.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+
+#include "lsst/pex/exceptions/Runtime.h"
+#include "lsst/daf/base/DateTime.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+namespace {
+
+// The first component of a hierarchical name, which selects the shard
+std::string_view topLevel(std::string_view name) { return name.substr(0, name.find('.')); }
+
+}  // namespace
+
+// Each shard gets its own cache line, so that locking one does not slow
+// threads using its neighbours
+struct alignas(64) ConcurrentPropertySet::Shard {
+    mutable std::shared_mutex mutex;
+    PropertySet set;
+};
+
+ConcurrentPropertySet::ConcurrentPropertySet(std::size_t shards) : _shardCount(shards) {
+    if (shards == 0) {
+        throw LSST_EXCEPT(pex::exceptions::InvalidParameterError,
+                          "A ConcurrentPropertySet needs at least one shard");
+    }
+    _shards.reset(new Shard[shards]);
+}
+
+ConcurrentPropertySet::~ConcurrentPropertySet() noexcept = default;
+
+///////////////////////////////////////////////////////////////////////////////
+// Accessors
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+T ConcurrentPropertySet::get(std::string_view name) const {
+    Shard const& shard = _shardFor(name);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return PropertySet::_isolate(shard.set.get<T>(name));
+}
+
+template <typename T>
+T ConcurrentPropertySet::get(std::string_view name, T const& defaultValue) const {
+    Shard const& shard = _shardFor(name);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return PropertySet::_isolate(shard.set.get<T>(name, defaultValue));
+}
+
+template <typename T>
+std::vector<T> ConcurrentPropertySet::getArray(std::string_view name) const {
+    Shard const& shard = _shardFor(name);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return PropertySet::_isolate(shard.set.getArray<T>(name));
+}
+
+bool ConcurrentPropertySet::exists(std::string_view name) const {
+    Shard const& shard = _shardFor(name);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.set.exists(name);
+}
+
+std::vector<std::string> ConcurrentPropertySet::names(bool topLevelOnly) const {
+    // Writers only ever hold one lock, so taking them all in order cannot deadlock
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(_shardCount);
+    for (std::size_t i = 0; i < _shardCount; ++i) {
+        locks.emplace_back(_shards[i].mutex);
+    }
+    std::vector<std::string> result;
+    for (std::size_t i = 0; i < _shardCount; ++i) {
+        std::vector<std::string> shardNames = _shards[i].set.names(topLevelOnly);
+        std::move(shardNames.begin(), shardNames.end(), std::back_inserter(result));
+    }
+    return result;
+}
+
+std::shared_ptr<PropertySet> ConcurrentPropertySet::deepCopy() const {
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(_shardCount);
+    for (std::size_t i = 0; i < _shardCount; ++i) {
+        locks.emplace_back(_shards[i].mutex);
+    }
+    // Shards hold disjoint top-level names, so each is copied straight into the result
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < _shardCount; ++i) {
+        count += _shards[i].set.nameCount();
+    }
+    auto result = std::make_shared<PropertySet>();
+    result->reserve(count);
+    for (std::size_t i = 0; i < _shardCount; ++i) {
+        result->_mergeCopyFrom(_shards[i].set);
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Modifiers
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void ConcurrentPropertySet::set(std::string const& name, T const& value) {
+    T const copy = PropertySet::_isolate(value);
+    Shard& shard = _shardFor(name);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.set.set(name, copy);
+}
+
+template <typename T>
+void ConcurrentPropertySet::set(std::string const& name, std::vector<T> const& value) {
+    std::vector<T> copy = PropertySet::_isolate(value);
+    Shard& shard = _shardFor(name);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.set.set(name, std::move(copy));
+}
+
+void ConcurrentPropertySet::set(std::string const& name, char const* value) { set(name, std::string(value)); }
+
+template <typename T>
+void ConcurrentPropertySet::add(std::string const& name, T const& value) {
+    T const copy = PropertySet::_isolate(value);
+    Shard& shard = _shardFor(name);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.set.add(name, copy);
+}
+
+template <typename T>
+void ConcurrentPropertySet::add(std::string const& name, std::vector<T> const& value) {
+    std::vector<T> copy = PropertySet::_isolate(value);
+    Shard& shard = _shardFor(name);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.set.add(name, std::move(copy));
+}
+
+void ConcurrentPropertySet::add(std::string const& name, char const* value) { add(name, std::string(value)); }
+
+void ConcurrentPropertySet::remove(std::string const& name) {
+    Shard& shard = _shardFor(name);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.set.remove(name);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private member functions
+///////////////////////////////////////////////////////////////////////////////
+
+ConcurrentPropertySet::Shard& ConcurrentPropertySet::_shardFor(std::string_view name) const {
+    return _shards[std::hash<std::string_view>()(topLevel(name)) % _shardCount];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Explicit template instantiations
+///////////////////////////////////////////////////////////////////////////////
+
+/// @cond
+// Explicit template instantiations are not well understood by doxygen.
+
+#define INSTANTIATE(t)                                                                                 \
+    template t ConcurrentPropertySet::get<t>(std::string_view name) const;                             \
+    template t ConcurrentPropertySet::get<t>(std::string_view name, t const& defaultValue) const;      \
+    template std::vector<t> ConcurrentPropertySet::getArray<t>(std::string_view name) const;           \
+    template void ConcurrentPropertySet::set<t>(std::string const& name, t const& value);              \
+    template void ConcurrentPropertySet::set<t>(std::string const& name, std::vector<t> const& value); \
+    template void ConcurrentPropertySet::add<t>(std::string const& name, t const& value);              \
+    template void ConcurrentPropertySet::add<t>(std::string const& name, std::vector<t> const& value);
+
+INSTANTIATE(bool)
+INSTANTIATE(char)
+INSTANTIATE(signed char)
+INSTANTIATE(unsigned char)
+INSTANTIATE(short)
+INSTANTIATE(unsigned short)
+INSTANTIATE(int)
+INSTANTIATE(unsigned int)
+INSTANTIATE(long)
+INSTANTIATE(unsigned long)
+INSTANTIATE(long long)
+INSTANTIATE(unsigned long long)
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(std::nullptr_t)
+INSTANTIATE(std::string)
+INSTANTIATE(std::shared_ptr<PropertySet>)
+INSTANTIATE(Persistable::Ptr)
+INSTANTIATE(DateTime)
+
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+/// @endcond
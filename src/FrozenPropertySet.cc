@@ -0,0 +1,308 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "lsst/daf/base/FrozenPropertySet.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "lsst/pex/exceptions/Runtime.h"
+#include "lsst/daf/base/DateTime.h"
+#include "lsst/daf/base/PropertyList.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+namespace {
+
+/*
+ * The perfect hash is built by "hash and displace": names are grouped into
+ * buckets of about BUCKET_SIZE by their hash, and each bucket, largest
+ * first, is given the smallest seed that sends all of its names to free
+ * slots.  A lookup reads the seed of the name's bucket and then one slot.
+ */
+std::size_t const BUCKET_SIZE = 4;
+
+// Give up rather than search forever; only reachable if two names have the same full hash
+std::uint32_t const MAX_SEED = 1U << 24;
+
+std::size_t hashName(std::string_view name) noexcept { return std::hash<std::string_view>()(name); }
+
+// Slot of a name with the given hash and bucket seed, in a table of n slots
+std::size_t slotOf(std::size_t hash, std::uint32_t seed, std::size_t n) noexcept {
+    // splitmix64 finalizer, so that each seed gives an independent placement
+    std::uint64_t x = hash + (seed + 1) * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x % n;
+}
+
+typedef std::shared_ptr<PropertySet> PropertySetPtr;
+
+}  // namespace
+
+FrozenPropertySet::FrozenPropertySet(std::shared_ptr<PropertySet const> tree) : _tree(std::move(tree)) {
+    std::vector<std::pair<std::string, Values const*>> entries;
+    _tree->_collect("", entries);
+    std::size_t const n = entries.size();
+    if (n == 0) {
+        return;
+    }
+
+    std::size_t const nBuckets = (n + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    std::vector<std::size_t> hashes(n);
+    std::vector<std::vector<std::size_t>> buckets(nBuckets);
+    for (std::size_t i = 0; i < n; ++i) {
+        hashes[i] = hashName(entries[i].first);
+        buckets[hashes[i] % nBuckets].push_back(i);
+    }
+    std::vector<std::size_t> order(nBuckets);
+    for (std::size_t b = 0; b < nBuckets; ++b) {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](std::size_t a, std::size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    _seeds.assign(nBuckets, 0);
+    std::vector<std::size_t> slotEntry(n, n);  // Entry placed in each slot, or n if free
+    std::vector<std::size_t> placed;
+    for (std::size_t b : order) {
+        std::vector<std::size_t> const& bucket = buckets[b];
+        if (bucket.empty()) {
+            break;
+        }
+        for (std::uint32_t seed = 0;; ++seed) {
+            if (seed == MAX_SEED) {
+                throw LSST_EXCEPT(pex::exceptions::RuntimeError, "Cannot index names of " +
+                                                                         entries[bucket.front()].first);
+            }
+            placed.clear();
+            for (std::size_t i : bucket) {
+                std::size_t const slot = slotOf(hashes[i], seed, n);
+                if (slotEntry[slot] != n || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+                    break;
+                }
+                placed.push_back(slot);
+            }
+            if (placed.size() == bucket.size()) {
+                for (std::size_t k = 0; k < bucket.size(); ++k) {
+                    slotEntry[placed[k]] = bucket[k];
+                }
+                _seeds[b] = seed;
+                break;
+            }
+        }
+    }
+
+    std::size_t nameBytes = 0;
+    for (auto const& entry : entries) {
+        nameBytes += entry.first.size();
+    }
+    if (nameBytes > std::numeric_limits<std::uint32_t>::max()) {
+        throw LSST_EXCEPT(pex::exceptions::LengthError, "Names too long to freeze");
+    }
+    _names.reserve(nameBytes);
+    _slots.resize(n);
+    for (std::size_t slot = 0; slot < n; ++slot) {
+        std::size_t const i = slotEntry[slot];
+        _slots[slot] = Slot{hashes[i], entries[i].second, static_cast<std::uint32_t>(_names.size()),
+                            static_cast<std::uint32_t>(entries[i].first.size())};
+        _names += entries[i].first;
+    }
+}
+
+FrozenPropertySet::~FrozenPropertySet() noexcept = default;
+
+std::shared_ptr<PropertySet> FrozenPropertySet::thaw() const { return _tree->deepCopy(); }
+
+bool FrozenPropertySet::isPropertyList() const noexcept {
+    return dynamic_cast<PropertyList const*>(_tree.get()) != nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Accessors
+///////////////////////////////////////////////////////////////////////////////
+
+std::size_t FrozenPropertySet::nameCount(bool topLevelOnly) const {
+    return topLevelOnly ? _tree->nameCount() : _slots.size();
+}
+
+std::vector<std::string> FrozenPropertySet::names(bool topLevelOnly) const {
+    return _tree->names(topLevelOnly);
+}
+
+std::vector<std::string> FrozenPropertySet::paramNames(bool topLevelOnly) const {
+    return _tree->paramNames(topLevelOnly);
+}
+
+std::vector<std::string> FrozenPropertySet::propertySetNames(bool topLevelOnly) const {
+    return _tree->propertySetNames(topLevelOnly);
+}
+
+bool FrozenPropertySet::isArray(std::string_view name) const noexcept {
+    Values const* values = _lookup(name);
+    return values && values->size() > 1U;
+}
+
+bool FrozenPropertySet::isPropertySetPtr(std::string_view name) const noexcept {
+    Values const* values = _lookup(name);
+    return values && values->type() == PropertySet::Type::PropertySet;
+}
+
+std::size_t FrozenPropertySet::valueCount(std::string_view name) const noexcept {
+    Values const* values = _lookup(name);
+    return values ? values->size() : 0;
+}
+
+std::type_info const& FrozenPropertySet::typeOf(std::string_view name) const {
+    return PropertySet::_typeOf(_at(name));
+}
+
+PropertySet::Type FrozenPropertySet::typeTag(std::string_view name) const { return _at(name).type(); }
+
+template <typename T>
+T FrozenPropertySet::get(std::string_view name) const {
+    return PropertySet::_isolate(PropertySet::_back<T>(_at(name), name));
+}
+
+template <typename T>
+T FrozenPropertySet::get(std::string_view name, T const& defaultValue) const {
+    Values const* values = _lookup(name);
+    if (!values) {
+        return defaultValue;
+    }
+    return PropertySet::_isolate(PropertySet::_back<T>(*values, name));
+}
+
+template <typename T>
+std::vector<T> FrozenPropertySet::getArray(std::string_view name) const {
+    std::vector<T> result = PropertySet::_toVector<T>(_at(name), name);
+    if constexpr (std::is_same<T, PropertySetPtr>::value) {
+        for (auto& value : result) {
+            value = PropertySet::_isolate(value);
+        }
+    }
+    return result;
+}
+
+template <typename T>
+PropertySet::ArrayView<T> FrozenPropertySet::getArrayView(std::string_view name) const {
+    static_assert(!std::is_same<T, PropertySetPtr>::value, "Nested PropertySets cannot be viewed");
+    return PropertySet::_view<T>(_at(name), name);
+}
+
+std::vector<std::string> FrozenPropertySet::getOrderedNames() const { return _list().getOrderedNames(); }
+
+std::string const& FrozenPropertySet::getComment(std::string const& name) const {
+    PropertyList const& list = _list();
+    if (!exists(name)) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    }
+    return list.getComment(name);
+}
+
+std::string FrozenPropertySet::toString(bool topLevelOnly, std::string const& indent) const {
+    return _tree->toString(topLevelOnly, indent);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private member functions
+///////////////////////////////////////////////////////////////////////////////
+
+FrozenPropertySet::Values const* FrozenPropertySet::_lookup(std::string_view name) const noexcept {
+    if (_slots.empty()) {
+        return nullptr;
+    }
+    std::size_t const hash = hashName(name);
+    Slot const& slot = _slots[slotOf(hash, _seeds[hash % _seeds.size()], _slots.size())];
+    if (slot.hash != hash || std::string_view(_names).substr(slot.nameBegin, slot.nameSize) != name) {
+        return nullptr;
+    }
+    return slot.values;
+}
+
+FrozenPropertySet::Values const& FrozenPropertySet::_at(std::string_view name) const {
+    Values const* values = _lookup(name);
+    if (!values) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
+    }
+    return *values;
+}
+
+PropertyList const& FrozenPropertySet::_list() const {
+    auto const* list = dynamic_cast<PropertyList const*>(_tree.get());
+    if (!list) {
+        throw LSST_EXCEPT(pex::exceptions::LogicError, "Snapshot was not made from a PropertyList");
+    }
+    return *list;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Explicit template instantiations
+///////////////////////////////////////////////////////////////////////////////
+
+/// @cond
+// Explicit template instantiations are not well understood by doxygen.
+
+#define INSTANTIATE(t)                                                                                  \
+    template t FrozenPropertySet::get<t>(std::string_view name) const;                                  \
+    template t FrozenPropertySet::get<t>(std::string_view name, t const& defaultValue) const;           \
+    template std::vector<t> FrozenPropertySet::getArray<t>(std::string_view name) const;                \
+    template PropertySet::ArrayView<t> FrozenPropertySet::getArrayView<t>(std::string_view name) const;
+
+#define INSTANTIATE_PROPERTY_SET(t)                                                           \
+    template t FrozenPropertySet::get<t>(std::string_view name) const;                        \
+    template t FrozenPropertySet::get<t>(std::string_view name, t const& defaultValue) const; \
+    template std::vector<t> FrozenPropertySet::getArray<t>(std::string_view name) const;
+
+INSTANTIATE(bool)
+INSTANTIATE(char)
+INSTANTIATE(signed char)
+INSTANTIATE(unsigned char)
+INSTANTIATE(short)
+INSTANTIATE(unsigned short)
+INSTANTIATE(int)
+INSTANTIATE(unsigned int)
+INSTANTIATE(long)
+INSTANTIATE(unsigned long)
+INSTANTIATE(long long)
+INSTANTIATE(unsigned long long)
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(std::nullptr_t)
+INSTANTIATE(std::string)
+INSTANTIATE_PROPERTY_SET(std::shared_ptr<PropertySet>)
+INSTANTIATE(Persistable::Ptr)
+INSTANTIATE(DateTime)
+
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+/// @endcond
@@ -25,12 +25,13 @@
 #include "lsst/daf/base/PropertyList.h"
 
 #include <algorithm>
-#include <iomanip>
-#include <sstream>
 #include <stdexcept>
-#include <any>
+#include <string_view>
+#include <unordered_set>
 
 #include "lsst/daf/base/DateTime.h"
+#include "lsst/daf/base/PropertySetPatch.h"
+#include "lsst/daf/base/detail/Fingerprint.h"
 
 namespace lsst {
 namespace daf {
@@ -40,17 +41,31 @@ namespace base {
  */
 PropertyList::PropertyList() : PropertySet(true) {}
 
+PropertyList::PropertyList(std::pmr::memory_resource* resource)
+        : PropertySet(resource, true), _comments(resource), _order(resource) {}
+
 /** Destructor.
  */
 PropertyList::~PropertyList() noexcept = default;
 
+PropertyList::PropertyList(PropertyList&& other) noexcept = default;
+
+PropertyList& PropertyList::operator=(PropertyList&& other) noexcept = default;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Accessors
 ///////////////////////////////////////////////////////////////////////////////
 
 std::shared_ptr<PropertySet> PropertyList::deepCopy() const {
-    std::shared_ptr<PropertyList> n(new PropertyList);
-    n->PropertySet::combine(*this->PropertySet::deepCopy());
+    std::pmr::memory_resource* resource = getMemoryResource();
+    std::shared_ptr<PropertyList> n;
+    if (resource == std::pmr::new_delete_resource()) {
+        n.reset(new PropertyList);
+    } else {
+        n = std::allocate_shared<PropertyList>(std::pmr::polymorphic_allocator<PropertyList>(resource),
+                                               resource);
+    }
+    n->_deepCopyFrom(*this);
     n->_order = _order;
     n->_comments = _comments;
     return n;
@@ -59,48 +74,67 @@ std::shared_ptr<PropertySet> PropertyList::deepCopy() const {
 // The following throw an exception if the type does not match exactly.
 
 template <typename T>
-T PropertyList::get(std::string const& name)
+T PropertyList::get(std::string_view name)
         const { /* parasoft-suppress LsstDm-3-4a LsstDm-4-6 "allow template over bool" */
     return PropertySet::get<T>(name);
 }
 
 template <typename T>
-T PropertyList::get(std::string const& name, T const& defaultValue)
+T PropertyList::get(std::string_view name, T const& defaultValue)
         const { /* parasoft-suppress LsstDm-3-4a LsstDm-4-6 "allow template over bool" */
     return PropertySet::get<T>(name, defaultValue);
 }
 
 template <typename T>
-std::vector<T> PropertyList::getArray(std::string const& name) const {
+std::vector<T> PropertyList::getArray(std::string_view name) const {
     return PropertySet::getArray<T>(name);
 }
 
 std::string const& PropertyList::getComment(std::string const& name) const {
-    return _comments.find(name)->second;
+    return _comments->find(name)->second;
 }
 
 std::vector<std::string> PropertyList::getOrderedNames() const {
     std::vector<std::string> v;
-    for (auto const& name : _order) {
+    for (auto const& name : *_order) {
         v.push_back(name);
     }
     return v;
 }
 
-std::list<std::string>::const_iterator PropertyList::begin() const { return _order.begin(); }
+std::list<std::string>::const_iterator PropertyList::begin() const { return _order->begin(); }
+
+std::list<std::string>::const_iterator PropertyList::end() const { return _order->end(); }
 
-std::list<std::string>::const_iterator PropertyList::end() const { return _order.end(); }
+std::uint64_t PropertyList::fingerprint(bool withComments, bool withOrder) const {
+    std::uint64_t result = PropertySet::fingerprint();
+    if (withComments) {
+        // Summed, like the values, so independent of the order
+        std::uint64_t comments = 0;
+        for (auto const& name : *_order) {
+            std::string const& comment = _comments->find(name)->second;
+            comments += detail::fingerprintBytes(detail::fingerprintBytes(1, name), comment);
+        }
+        result += detail::fingerprintMix(comments ^ 0x243F6A8885A308D3ULL);
+    }
+    if (withOrder) {
+        std::uint64_t order = 0;
+        for (auto const& name : *_order) {
+            order = detail::fingerprintBytes(order, name);
+        }
+        result += detail::fingerprintMix(order ^ 0x13198A2E03707344ULL);
+    }
+    return result;
+}
 
-std::string PropertyList::toString(bool topLevelOnly, std::string const& indent) const {
-    std::ostringstream s;
-    for (auto const& name : _order) {
-        s << _format(name);
-        std::string const& comment = _comments.find(name)->second;
+void PropertyList::_write(std::string& out, bool topLevelOnly, std::string const& indent) const {
+    for (auto const& name : *_order) {
+        _format(out, name);
+        std::string const& comment = _comments->find(name)->second;
         if (comment.size()) {
-            s << "// " << comment << std::endl;
+            ((out += "// ") += comment) += '\n';
         }
     }
-    return s.str();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -118,8 +152,8 @@ void PropertyList::set(std::string const& name, T const& value) {
 void PropertyList::set(std::string const& name, std::shared_ptr<PropertySet> const& value) {
     auto pl = std::dynamic_pointer_cast<PropertyList, PropertySet>(value);
     PropertySet::set(name, value);
-    _comments.erase(name);
-    _order.remove(name);
+    _comments.write().erase(name);
+    _order.write().remove(name);
     std::vector<std::string> paramNames = value->paramNames(false);
     if (pl) {
         for (auto const& paramName : paramNames) {
@@ -128,6 +162,15 @@ void PropertyList::set(std::string const& name, std::shared_ptr<PropertySet> con
     }
 }
 
+template <typename T>
+void PropertyList::set(std::string const& name, std::vector<T>&& value) {
+    PropertySet::set(name, std::move(value));
+}
+
+void PropertyList::set(std::string const& name, std::string&& value) {
+    PropertySet::set(name, std::move(value));
+}
+
 void PropertyList::set(std::string const& name, char const* value) { set(name, std::string(value)); }
 
 template <typename T>
@@ -140,6 +183,15 @@ void PropertyList::add(std::string const& name, T const& value) {
     PropertySet::add(name, value);
 }
 
+template <typename T>
+void PropertyList::add(std::string const& name, std::vector<T>&& value) {
+    PropertySet::add(name, std::move(value));
+}
+
+void PropertyList::add(std::string const& name, std::string&& value) {
+    PropertySet::add(name, std::move(value));
+}
+
 void PropertyList::add(std::string const& name, char const* value) { add(name, std::string(value)); }
 
 template <typename T>
@@ -160,6 +212,18 @@ void PropertyList::set(std::string const& name, char const* value, std::string c
     set(name, std::string(value), comment);
 }
 
+template <typename T>
+void PropertyList::set(std::string const& name, std::vector<T>&& value, std::string const& comment) {
+    PropertySet::set(name, std::move(value));
+    _commentOrderFix(name, comment);
+}
+
+void PropertyList::set(std::string const& name, std::string&& value, std::string const& comment) {
+    PropertySet::set(name, std::move(value));
+    _commentOrderFix(name, comment);
+}
+
+
 template <typename T>
 void PropertyList::set(std::string const& name, std::vector<T> const& value, std::string const& comment) {
     PropertySet::set(name, value);
@@ -175,6 +239,17 @@ void PropertyList::add(std::string const& name, char const* value, std::string c
     add(name, std::string(value), comment);
 }
 
+template <typename T>
+void PropertyList::add(std::string const& name, std::vector<T>&& value, std::string const& comment) {
+    PropertySet::add(name, std::move(value));
+    _commentOrderFix(name, comment);
+}
+
+void PropertyList::add(std::string const& name, std::string&& value, std::string const& comment) {
+    PropertySet::add(name, std::move(value));
+    _commentOrderFix(name, comment);
+}
+
 template <typename T>
 void PropertyList::add(std::string const& name, std::vector<T> const& value, std::string const& comment) {
     PropertySet::add(name, value);
@@ -189,7 +264,7 @@ void PropertyList::copy(std::string const& dest, PropertySet const & source, std
     PropertySet::copy(dest, source, name, asScalar);
     auto const * pl = dynamic_cast<PropertyList const *>(&source);
     if (pl) {
-        _comments[name] = pl->_comments.find(name)->second;
+        _comments.write().insert_or_assign(name, pl->_comments->find(name)->second);
     }
 }
 
@@ -198,9 +273,9 @@ void PropertyList::combine(PropertySet const & source) {
     auto const * pl = dynamic_cast<PropertyList const *>(&source);
     std::list<std::string> newOrder;
     if (pl) {
-        newOrder = _order;
+        newOrder = *_order;
         for (auto const& name : *pl) {
-            bool present = _comments.find(name) != _comments.end();
+            bool present = _comments->find(name) != _comments->end();
             if (!present) {
                 newOrder.push_back(name);
             }
@@ -208,39 +283,138 @@ void PropertyList::combine(PropertySet const & source) {
     }
     PropertySet::combine(source);
     if (pl) {
-        _order = newOrder;
+        _order.reset(std::move(newOrder));
         for (auto const& name : *pl) {
-            _comments[name] = pl->_comments.find(name)->second;
+            _comments.write().insert_or_assign(name, pl->_comments->find(name)->second);
         }
     }
 }
 
+void PropertyList::combine(PropertySet&& source) {
+    auto * pl = dynamic_cast<PropertyList *>(&source);
+    std::list<std::string> newOrder;
+    if (pl) {
+        newOrder = *_order;
+        for (auto const& name : *pl) {
+            bool present = _comments->find(name) != _comments->end();
+            if (!present) {
+                newOrder.push_back(name);
+            }
+        }
+    }
+    PropertySet::combine(std::move(source));
+    if (pl) {
+        _order.reset(std::move(newOrder));
+        CommentMap& comments = pl->_comments.write();
+        for (auto& elt : comments) {
+            _comments.write().insert_or_assign(elt.first.view(), std::move(elt.second));
+        }
+        pl->_comments.reset();
+        pl->_order.reset();
+    }
+}
+
+void PropertyList::apply(PropertySetPatch const& patch) {
+    PropertySet::apply(patch);
+    for (auto const& edit : patch.getEdits()) {
+        if (edit.kind != PropertySetPatch::Edit::Kind::Remove) {
+            _comments.write().insert_or_assign(edit.name, edit.comment);
+        }
+    }
+    if (patch.getOrder().empty()) {
+        return;
+    }
+    // Names the patch does not know about keep their order, after the others
+    std::list<std::string> newOrder;
+    std::unordered_set<std::string_view> placed;
+    for (auto const& name : patch.getOrder()) {
+        if (_comments->find(name) != _comments->end() && placed.insert(name).second) {
+            newOrder.push_back(name);
+        }
+    }
+    for (auto const& name : *_order) {
+        if (placed.find(name) == placed.end()) {
+            newOrder.push_back(name);
+        }
+    }
+    _order.reset(std::move(newOrder));
+}
 
-void PropertyList::remove(std::string const& name) {
-    PropertySet::remove(name);
-    _comments.erase(name);
-    _order.remove(name);
+void PropertyList::reserve(std::size_t n) {
+    PropertySet::reserve(n);
+    _comments.write().reserve(n);
+}
+
+void PropertyList::setAll(std::vector<Item> items) {
+    reserve(_comments->size() + items.size());
+    for (auto& item : items) {
+        if (_isTopLevel(item)) {
+            if (_setTopLevel(item._name, std::move(item._values))) {
+                _comments.write().try_emplace(item._name, item._comment.value_or(std::string()));
+                _order.write().push_back(item._name);
+            } else if (item._comment) {
+                _comments.write().insert_or_assign(item._name, std::move(*item._comment));
+            }
+        } else if (!item._empty) {
+            // PropertySets are flattened, which needs the full treatment of set
+            if (item._comment) {
+                set(item._name, item._getPropertySet(), *item._comment);
+            } else {
+                set(item._name, item._getPropertySet());
+            }
+        }
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // Private member functions
 ///////////////////////////////////////////////////////////////////////////////
 
-void PropertyList::_set(std::string const& name, std::shared_ptr<std::vector<std::any> > vp) {
-    PropertySet::_set(name, vp);
-    if (_comments.find(name) == _comments.end()) {
-        _comments.insert(std::make_pair(name, std::string()));
-        _order.push_back(name);
+void PropertyList::_set(std::string const& name, Values values) {
+    PropertySet::_set(name, std::move(values));
+    if (_comments->find(name) == _comments->end()) {
+        _comments.write().try_emplace(name);
+        _order.write().push_back(name);
+    }
+}
+
+bool PropertyList::_remove(std::string_view name) {
+    if (_comments->find(name) == _comments->end()) {
+        return false;
     }
+    PropertySet::_remove(name);
+    _comments.write().erase(name);
+    _order.write().remove(std::string(name));
+    return true;
 }
 
 void PropertyList::_moveToEnd(std::string const& name) {
-    _order.remove(name);
-    _order.push_back(name);
+    _order.write().remove(name);
+    _order.write().push_back(name);
 }
 
 void PropertyList::_commentOrderFix(std::string const& name, std::string const& comment) {
-    _comments[name] = comment;
+    _comments.write().insert_or_assign(name, comment);
+}
+
+bool PropertyList::_sameContents(PropertySet const& other) const {
+    auto const& list = static_cast<PropertyList const&>(other);
+    if (&*_order != &*list._order && *_order != *list._order) {
+        return false;
+    }
+    if (!PropertySet::_sameContents(other)) {
+        return false;
+    }
+    if (&*_comments == &*list._comments) {
+        return true;
+    }
+    // The orders are equal, so both have comments for the same names
+    for (auto const& name : *_order) {
+        if (_comments->find(name)->second != list._comments->find(name)->second) {
+            return false;
+        }
+    }
+    return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -251,9 +425,9 @@ void PropertyList::_commentOrderFix(std::string const& name, std::string const&
 // Explicit template instantiations are not well understood by doxygen.
 
 #define INSTANTIATE(t)                                                                                       \
-    template t PropertyList::get<t>(std::string const& name) const;                                          \
-    template t PropertyList::get<t>(std::string const& name, t const& defaultValue) const;                   \
-    template std::vector<t> PropertyList::getArray<t>(std::string const& name) const;                        \
+    template t PropertyList::get<t>(std::string_view name) const;                                            \
+    template t PropertyList::get<t>(std::string_view name, t const& defaultValue) const;                     \
+    template std::vector<t> PropertyList::getArray<t>(std::string_view name) const;                          \
     template void PropertyList::set<t>(std::string const& name, t const& value);                             \
     template void PropertyList::set<t>(std::string const& name, std::vector<t> const& value);                \
     template void PropertyList::add<t>(std::string const& name, t const& value);                             \
@@ -269,7 +443,13 @@ void PropertyList::_commentOrderFix(std::string const& name, std::string const&
                                        char const* comment);                                                 \
     template void PropertyList::add<t>(std::string const& name, t const& value, char const* comment);        \
     template void PropertyList::add<t>(std::string const& name, std::vector<t> const& value,                 \
-                                       char const* comment);
+                                       char const* comment);                                                 \
+    template void PropertyList::set<t>(std::string const& name, std::vector<t>&& value);                     \
+    template void PropertyList::add<t>(std::string const& name, std::vector<t>&& value);                     \
+    template void PropertyList::set<t>(std::string const& name, std::vector<t>&& value,                      \
+                                       std::string const& comment);                                          \
+    template void PropertyList::add<t>(std::string const& name, std::vector<t>&& value,                      \
+                                       std::string const& comment);
 
 INSTANTIATE(bool)
 INSTANTIATE(char)
@@ -25,13 +25,25 @@
 #include "lsst/daf/base/PropertySet.h"
 
 #include <algorithm>
-#include <iomanip>
-#include <sstream>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <ostream>
 #include <stdexcept>
-#include <any>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
 
 #include "lsst/pex/exceptions/Runtime.h"
 #include "lsst/daf/base/DateTime.h"
+#include "lsst/daf/base/FrozenPropertySet.h"
+#include "lsst/daf/base/PropertySetPatch.h"
+#include "lsst/daf/base/PropertySetSnapshot.h"
+#include "lsst/daf/base/detail/Fingerprint.h"
 
 namespace lsst {
 namespace daf {
@@ -39,57 +51,588 @@ namespace base {
 
 namespace {
 
+using detail::TypeIdentity;
+using detail::TypeIndex;
+using detail::ValueTypes;
+
 /**
- * Append the contents of a vector<T> to a vector<std::any>
- *
- * This method exists because vector<std::any>.insert mis-behaves for vector of bool,
- * resulting in a vector with elements that are a strange type.
+ * Call f(TypeIdentity<T>()) for the value type T identified by a type tag,
+ * through a jump table.
  */
+template <typename F>
+decltype(auto) dispatch(PropertySet::Type type, F&& f) {
+    return detail::dispatch(static_cast<std::size_t>(type), std::forward<F>(f));
+}
+
+// Append a single value in human-readable form to out; used by _format.
+// Numbers are written with std::to_chars rather than through a stream.
 template <typename T>
-void _append(std::vector<std::any>& dest, std::vector<T> const& src) {
-    dest.reserve(dest.size() + src.size());
-    for (const T& val : src) {
-        dest.push_back(static_cast<T>(val));
+void _formatValue(std::string& out, T v) {
+    char buffer[24];
+    auto const result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+    out.append(buffer, result.ptr);
+}
+
+// As printf("%#.*g", precision, v): the shortest of fixed and scientific
+// notation, always with a decimal point and keeping trailing zeros
+template <typename T>
+void _formatFloat(std::string& out, T v, int precision) {
+    char buffer[64];
+    char* const end = buffer + sizeof(buffer);
+    auto result = std::to_chars(buffer, end, v, std::chars_format::scientific, precision - 1);
+    char const* const e = std::find(buffer, result.ptr, 'e');
+    if (e == result.ptr) {
+        out.append(buffer, result.ptr);  // inf or nan
+        return;
+    }
+    int exponent = 0;
+    std::from_chars(e + (e[1] == '+' ? 2 : 1), result.ptr, exponent);
+    if (exponent < -4 || exponent >= precision) {
+        out.append(buffer, result.ptr);
+        return;
+    }
+    result = std::to_chars(buffer, end, v, std::chars_format::fixed, precision - 1 - exponent);
+    out.append(buffer, result.ptr);
+    if (exponent == precision - 1) {
+        out += '.';
     }
 }
 
+void _formatValue(std::string& out, bool v) { out += v ? '1' : '0'; }
+void _formatValue(std::string& out, char v) { ((out += '\'') += v) += '\''; }
+void _formatValue(std::string& out, signed char v) { _formatValue(out, static_cast<char>(v)); }
+void _formatValue(std::string& out, unsigned char v) { _formatValue(out, static_cast<char>(v)); }
+void _formatValue(std::string& out, float v) { _formatFloat(out, v, 7); }
+void _formatValue(std::string& out, double v) { _formatFloat(out, v, 14); }
+void _formatValue(std::string& out, std::nullptr_t) { out += "<Unknown>"; }
+void _formatValue(std::string& out, std::string const& v) { ((out += '"') += v) += '"'; }
+void _formatValue(std::string& out, DateTime const& v) { out += v.toString(DateTime::UTC); }
+void _formatValue(std::string& out, std::shared_ptr<PropertySet> const&) { out += "{ ... }"; }
+void _formatValue(std::string& out, Persistable::Ptr const&) { out += "<Persistable>"; }
+
+// Hash a single value, identically on every platform; used by _contribution.
+// Values that compare equal must hash equal, so all NaNs hash alike, as do
+// both zeros.  Values without a portable representation hash to zero.
+template <typename T>
+std::uint64_t _fingerprintValue(T const& v) {
+    if constexpr (std::is_same<T, char>::value) {
+        return static_cast<unsigned char>(v);  // Signed on some platforms only
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        return static_cast<std::uint64_t>(static_cast<std::int64_t>(v));
+    } else if constexpr (std::is_integral<T>::value) {
+        return static_cast<std::uint64_t>(v);
+    } else if constexpr (std::is_floating_point<T>::value) {
+        if (std::isnan(v)) {
+            return 0x7FF8000000000000ULL;
+        }
+        double const x = v == 0 ? 0.0 : static_cast<double>(v);
+        std::uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return bits;
+    } else {
+        return 0;
+    }
+}
+
+std::uint64_t _fingerprintValue(std::string const& v) { return detail::fingerprintBytes(0, v); }
+std::uint64_t _fingerprintValue(DateTime const& v) { return static_cast<std::uint64_t>(v.nsecs()); }
+
+// Fingerprint contribution of a null PropertySet
+std::uint64_t const NULL_SET_FINGERPRINT = 0x6A09E667F3BCC908ULL;
+
 }  // namespace
 
-PropertySet::PropertySet(bool flat) : _flat(flat) {}
+///////////////////////////////////////////////////////////////////////////////
+// Value storage
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Header of an out-of-line array; the values follow it in the same
+ * allocation, which comes from the block's memory resource (operator new if
+ * null).  Copies of a cell share its block until one of them is modified.
+ * The static members manage the storage of a Values cell; new blocks come
+ * from the resource passed to them.
+ */
+struct PropertySet::Values::Block {
+    static_assert(sizeof(Values) == 16, "PropertySet::Values should fit in 16 bytes");
+
+    std::size_t size;
+    std::size_t capacity;
+    std::atomic<std::size_t> refs;
+    std::pmr::memory_resource* resource;
+
+    Block(std::size_t capacity_, std::pmr::memory_resource* resource_)
+            : size(0), capacity(capacity_), refs(1), resource(resource_) {}
+
+    /// Types stored inline when there is a single value (std::string is handled separately)
+    template <typename T>
+    static constexpr bool isInline = std::is_trivially_copyable<T>::value && sizeof(T) <= INLINE_SIZE;
+
+    template <typename T>
+    T* data() noexcept {
+        return reinterpret_cast<T*>(this + 1);
+    }
+
+    template <typename T>
+    T const* data() const noexcept {
+        return reinterpret_cast<T const*>(this + 1);
+    }
+
+    /// Allocate an empty block
+    template <typename T>
+    static Block* allocate(std::size_t capacity, std::pmr::memory_resource* resource) {
+        static_assert(sizeof(Block) % alignof(T) == 0, "Misaligned values");
+        std::size_t const bytes = sizeof(Block) + capacity * sizeof(T);
+        void* p = resource ? resource->allocate(bytes, alignof(Block)) : ::operator new(bytes);
+        return new (p) Block(capacity, resource);
+    }
+
+    /// Free the storage of a block whose values have been destroyed
+    template <typename T>
+    static void deallocate(Block* block) noexcept {
+        std::pmr::memory_resource* resource = block->resource;
+        std::size_t const bytes = sizeof(Block) + block->capacity * sizeof(T);
+        block->~Block();
+        if (resource) {
+            resource->deallocate(block, bytes, alignof(Block));
+        } else {
+            ::operator delete(block);
+        }
+    }
+
+    /// Drop a reference to a block; destroy its values and free it if it was the last
+    template <typename T>
+    static void release(Block* block) noexcept {
+        if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::destroy_n(block->data<T>(), block->size);
+            deallocate<T>(block);
+        }
+    }
+
+    /// Allocate a block and fill it with copies of the given values
+    template <typename T, typename Iter>
+    static Block* make(Iter first, std::size_t size, std::size_t capacity,
+                       std::pmr::memory_resource* resource) {
+        Block* block = allocate<T>(capacity, resource);
+        try {
+            std::uninitialized_copy_n(first, size, block->data<T>());
+        } catch (...) {
+            deallocate<T>(block);
+            throw;
+        }
+        block->size = size;
+        return block;
+    }
+
+    static Block* get(Values const& v) noexcept {
+        Block* block;
+        std::memcpy(&block, v._data, sizeof(block));
+        return block;
+    }
+
+    static void put(Values& v, Block* block) noexcept {
+        std::memcpy(v._data, &block, sizeof(block));
+        v._state = OUT_OF_LINE;
+    }
+
+    /// Store a single value, copied or moved, in a cell whose storage is empty
+    template <typename U>
+    static void init(Values& v, U&& value, std::pmr::memory_resource* resource) {
+        typedef std::decay_t<U> T;
+        if constexpr (isInline<T>) {
+            std::memcpy(v._data, &value, sizeof(T));
+            v._state = 0;
+        } else if constexpr (std::is_same<T, std::string>::value) {
+            if (value.size() <= INLINE_SIZE) {
+                std::memcpy(v._data, value.data(), value.size());
+                v._state = static_cast<std::uint8_t>(value.size());
+            } else {
+                put(v, make<T>(forwardIterator<U>(&value), 1, 1, resource));
+            }
+        } else {
+            put(v, make<T>(forwardIterator<U>(&value), 1, 1, resource));
+        }
+    }
+
+    /// An iterator that moves from the values if U is an rvalue type
+    template <typename U, typename Iter>
+    static auto forwardIterator(Iter it) {
+        if constexpr (std::is_lvalue_reference<U>::value) {
+            return it;
+        } else {
+            return std::make_move_iterator(it);
+        }
+    }
+
+    /// The value stored inline in a cell
+    template <typename T>
+    static T inlineValue(Values const& v) {
+        if constexpr (isInline<T>) {
+            T value;
+            std::memcpy(&value, v._data, sizeof(T));
+            return value;
+        } else if constexpr (std::is_same<T, std::string>::value) {
+            return std::string(reinterpret_cast<char const*>(v._data), v._state);
+        } else {
+            throw LSST_EXCEPT(pex::exceptions::LogicError, "Value type is never stored inline");
+        }
+    }
+
+    /**
+     * Make sure a cell is out of line, with a block of its own that has room
+     * for at least n values, and return the block
+     */
+    template <typename T>
+    static Block* reserve(Values& v, std::size_t n, std::pmr::memory_resource* resource) {
+        if (v._state != OUT_OF_LINE) {
+            T const value = inlineValue<T>(v);
+            put(v, make<T>(&value, 1, std::max<std::size_t>(n, 2), resource));
+        }
+        Block* block = get(v);
+        if (block->refs.load(std::memory_order_acquire) > 1) {
+            Block* copy = make<T>(block->data<T>(), block->size, std::max(n, block->capacity), resource);
+            release<T>(block);
+            put(v, copy);
+            block = copy;
+        }
+        if (block->capacity < n) {
+            Block* grown = allocate<T>(std::max(n, 2 * block->capacity), resource);
+            std::uninitialized_move_n(block->data<T>(), block->size, grown->data<T>());
+            grown->size = block->size;
+            release<T>(block);
+            put(v, grown);
+            block = grown;
+        }
+        return block;
+    }
+};
+
+template <typename T>
+PropertySet::Values::Values(T const& value, std::pmr::memory_resource* resource) : _type(typeTagOfT<T>()) {
+    Block::init(*this, value, resource);
+}
+
+template <typename T>
+PropertySet::Values::Values(std::vector<T> const& values, std::pmr::memory_resource* resource)
+        : _type(typeTagOfT<T>()) {
+    if (values.size() == 1) {
+        Block::init(*this, static_cast<T>(values.front()), resource);
+    } else {
+        Block::put(*this, Block::make<T>(values.begin(), values.size(), values.size(), resource));
+    }
+}
+
+template <typename T>
+PropertySet::Values::Values(std::vector<T>&& values, std::pmr::memory_resource* resource)
+        : _type(typeTagOfT<T>()) {
+    if (values.size() == 1) {
+        Block::init(*this, static_cast<T>(std::move(values.front())), resource);
+    } else {
+        Block::put(*this, Block::make<T>(std::make_move_iterator(values.begin()), values.size(),
+                                         values.size(), resource));
+    }
+}
+
+PropertySet::Values::Values(std::string&& value, std::pmr::memory_resource* resource) : _type(Type::String) {
+    Block::init(*this, std::move(value), resource);
+}
+
+PropertySet::Values::Values(Values const& other) : _type(other._type), _state(other._state) {
+    std::memcpy(_data, other._data, INLINE_SIZE);
+    if (_state == OUT_OF_LINE) {
+        Block::get(*this)->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PropertySet::Values::Values(Values&& other) noexcept : _type(other._type), _state(other._state) {
+    std::memcpy(_data, other._data, INLINE_SIZE);
+    other._state = 0;
+}
+
+PropertySet::Values& PropertySet::Values::operator=(Values const& other) {
+    if (this != &other) {
+        *this = Values(other);
+    }
+    return *this;
+}
+
+PropertySet::Values& PropertySet::Values::operator=(Values&& other) noexcept {
+    if (this != &other) {
+        this->~Values();
+        new (this) Values(std::move(other));
+    }
+    return *this;
+}
+
+PropertySet::Values::~Values() noexcept {
+    if (_state == OUT_OF_LINE) {
+        Block* block = Block::get(*this);
+        dispatch(_type, [block](auto t) { Block::release<typename decltype(t)::type>(block); });
+    }
+}
+
+std::size_t PropertySet::Values::size() const {
+    return _state == OUT_OF_LINE ? Block::get(*this)->size : 1;
+}
+
+template <typename T>
+T PropertySet::Values::back() const {
+    if (_state != OUT_OF_LINE) {
+        return Block::inlineValue<T>(*this);
+    }
+    Block const* block = Block::get(*this);
+    return block->data<T>()[block->size - 1];
+}
+
+template <typename T>
+std::vector<T> PropertySet::Values::toVector() const {
+    if (_state != OUT_OF_LINE) {
+        return std::vector<T>(1, Block::inlineValue<T>(*this));
+    }
+    Block const* block = Block::get(*this);
+    return std::vector<T>(block->data<T>(), block->data<T>() + block->size);
+}
+
+template <typename T>
+PropertySet::ArrayView<T> PropertySet::Values::view() const {
+    if (_state == OUT_OF_LINE) {
+        Block const* block = Block::get(*this);
+        return ArrayView<T>(block->data<T>(), block->size);
+    }
+    if constexpr (std::is_same<T, std::string>::value) {
+        return ArrayView<T>(std::string_view(reinterpret_cast<char const*>(_data), _state));
+    } else if constexpr (Block::isInline<T>) {
+        // The cell's storage holds the value's bytes, with suitable alignment
+        return ArrayView<T>(reinterpret_cast<T const*>(_data), 1);
+    } else {
+        throw LSST_EXCEPT(pex::exceptions::LogicError, "Value type is never stored inline");
+    }
+}
+
+template <typename T>
+void PropertySet::Values::append(T const& value, std::pmr::memory_resource* resource) {
+    Block* block = Block::reserve<T>(*this, size() + 1, resource);
+    new (block->data<T>() + block->size) T(value);
+    ++block->size;
+}
+
+template <typename T>
+void PropertySet::Values::append(std::vector<T> const& values, std::pmr::memory_resource* resource) {
+    Block* block = Block::reserve<T>(*this, size() + values.size(), resource);
+    std::uninitialized_copy(values.begin(), values.end(), block->data<T>() + block->size);
+    block->size += values.size();
+}
+
+template <typename T>
+void PropertySet::Values::append(std::vector<T>&& values, std::pmr::memory_resource* resource) {
+    Block* block = Block::reserve<T>(*this, size() + values.size(), resource);
+    std::uninitialized_move(values.begin(), values.end(), block->data<T>() + block->size);
+    block->size += values.size();
+}
+
+void PropertySet::Values::append(std::string&& value, std::pmr::memory_resource* resource) {
+    Block* block = Block::reserve<std::string>(*this, size() + 1, resource);
+    new (block->data<std::string>() + block->size) std::string(std::move(value));
+    ++block->size;
+}
+
+void PropertySet::Values::append(Values const& other, std::pmr::memory_resource* resource) {
+    if (&other == this) {
+        append(Values(other), resource);
+        return;
+    }
+    other.visit([this, resource](auto const* data, std::size_t n) {
+        typedef std::remove_const_t<std::remove_pointer_t<decltype(data)>> T;
+        Block* block = Block::reserve<T>(*this, size() + n, resource);
+        std::uninitialized_copy_n(data, n, block->data<T>() + block->size);
+        block->size += n;
+    });
+}
+
+void PropertySet::Values::append(Values&& other, std::pmr::memory_resource* resource) {
+    if (&other == this || other._state != OUT_OF_LINE ||
+        Block::get(other)->refs.load(std::memory_order_acquire) > 1) {
+        // Inline values are cheap to copy, and shared blocks must not be disturbed
+        append(static_cast<Values const&>(other), resource);
+        return;
+    }
+    Block* source = Block::get(other);
+    dispatch(_type, [this, source, resource](auto t) {
+        typedef typename decltype(t)::type T;
+        Block* block = Block::reserve<T>(*this, size() + source->size, resource);
+        std::uninitialized_move_n(source->data<T>(), source->size, block->data<T>() + block->size);
+        block->size += source->size;
+    });
+}
+
+void PropertySet::Values::reserve(std::size_t n, std::pmr::memory_resource* resource) {
+    if (n <= size()) return;
+    dispatch(_type, [this, n, resource](auto t) {
+        Block::reserve<typename decltype(t)::type>(*this, n, resource);
+    });
+}
+
+PropertySet::Values PropertySet::Values::lastOnly(std::pmr::memory_resource* resource) const {
+    Values result;
+    visit([&result, resource](auto const* data, std::size_t n) {
+        result = Values(data[n - 1], resource);
+    });
+    return result;
+}
+
+void PropertySet::Values::rebind(std::pmr::memory_resource* resource) {
+    if (_state != OUT_OF_LINE) return;
+    Block* block = Block::get(*this);
+    if (block->resource == resource) return;
+    dispatch(_type, [this, block, resource](auto t) {
+        typedef typename decltype(t)::type T;
+        Block* copy;
+        if (block->refs.load(std::memory_order_acquire) > 1) {
+            copy = Block::make<T>(block->data<T>(), block->size, block->size, resource);
+        } else {
+            copy = Block::make<T>(std::make_move_iterator(block->data<T>()), block->size, block->size,
+                                  resource);
+        }
+        Block::release<T>(block);
+        Block::put(*this, copy);
+    });
+}
+
+template <typename F>
+void PropertySet::Values::visit(F&& f) const {
+    dispatch(_type, [this, &f](auto t) {
+        typedef typename decltype(t)::type T;
+        if (_state == OUT_OF_LINE) {
+            Block const* block = Block::get(*this);
+            f(block->data<T>(), block->size);
+        } else if constexpr (Block::isInline<T> || std::is_same<T, std::string>::value) {
+            T const value = Block::inlineValue<T>(*this);
+            f(&value, std::size_t(1));
+        }
+    });
+}
+
+template <typename T>
+PropertySet::Item::Item(std::string name, T const& value, std::optional<std::string> comment)
+        : _name(std::move(name)), _values(value), _empty(false), _comment(std::move(comment)) {}
+
+template <typename T>
+PropertySet::Item::Item(std::string name, std::vector<T> const& value, std::optional<std::string> comment)
+        : _name(std::move(name)), _empty(value.empty()), _comment(std::move(comment)) {
+    if (!_empty) {
+        _values = Values(value);
+    }
+}
+
+PropertySet::Item::Item(std::string name, char const* value, std::optional<std::string> comment)
+        : Item(std::move(name), std::string(value), std::move(comment)) {}
+
+std::shared_ptr<PropertySet> PropertySet::Item::_getPropertySet() const {
+    if (_empty || _values.type() != Type::PropertySet) {
+        return nullptr;
+    }
+    return _values.back<std::shared_ptr<PropertySet>>();
+}
+
+PropertySet::PropertySet(bool flat) : _flat(flat), _fingerprint(0), _nestedCount(0) {}
+
+PropertySet::PropertySet(std::pmr::memory_resource* resource, bool flat)
+        : _map(resource == std::pmr::new_delete_resource() ? nullptr : resource),
+          _flat(flat),
+          _fingerprint(0),
+          _nestedCount(0) {}
+
+std::pmr::memory_resource* PropertySet::getMemoryResource() const noexcept {
+    return _resource() ? _resource() : std::pmr::new_delete_resource();
+}
 
 PropertySet::~PropertySet() noexcept = default;
 
+PropertySet::PropertySet(PropertySet&& other) noexcept
+        : _map(std::move(other._map)),
+          _flat(other._flat),
+          _journal(std::move(other._journal)),
+          _fingerprint(std::exchange(other._fingerprint, 0)),
+          _nestedCount(std::exchange(other._nestedCount, 0)) {}
+
+PropertySet& PropertySet::operator=(PropertySet&& other) noexcept {
+    _map = std::move(other._map);
+    _flat = other._flat;
+    _journal = std::move(other._journal);
+    _fingerprint = std::exchange(other._fingerprint, 0);
+    _nestedCount = std::exchange(other._nestedCount, 0);
+    return *this;
+}
+
+void PropertySet::setNameInterning(bool enable) { detail::Name::setInterning(enable); }
+
+bool PropertySet::getNameInterning() { return detail::Name::isInterning(); }
+
+PropertySet::Path::Path(std::string name) : _name(std::move(name)), _hash(AnyMap::hash(_name)) {
+    std::string_view const view(_name);
+    std::size_t begin = 0;
+    for (;;) {
+        std::size_t const end = view.find('.', begin);
+        std::string_view const segment = view.substr(begin, end == view.npos ? view.npos : end - begin);
+        _segments.push_back(Segment{begin, segment.size(), AnyMap::hash(segment)});
+        if (end == view.npos) break;
+        begin = end + 1;
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Accessors
 ///////////////////////////////////////////////////////////////////////////////
 
 std::shared_ptr<PropertySet> PropertySet::deepCopy() const {
-    auto n = std::make_shared<PropertySet>(_flat);
-    for (auto const& elt : _map) {
-        if (elt.second->back().type() == typeid(std::shared_ptr<PropertySet>)) {
-            for (auto const& j : *elt.second) {
-                auto p = std::any_cast<std::shared_ptr<PropertySet>>(j);
-                if (p.get() == 0) {
-                    n->add(elt.first, std::shared_ptr<PropertySet>());
-                } else {
-                    n->add(elt.first, p->deepCopy());
-                }
+    auto n = _makeEmpty(_flat);
+    n->_deepCopyFrom(*this);
+    return n;
+}
+
+bool PropertySet::operator==(PropertySet const& other) const {
+    return this == &other || (typeid(*this) == typeid(other) && _sameContents(other));
+}
+
+std::uint64_t PropertySet::fingerprint() const {
+    std::uint64_t result = _fingerprint;
+    if (_nestedCount == 0) {
+        return result;
+    }
+    for (auto const& elt : *_map) {
+        if (elt.second.type() == Type::PropertySet) {
+            std::uint64_t h = detail::fingerprintBytes(static_cast<std::uint64_t>(Type::PropertySet) + 1,
+                                                       elt.first.view());
+            for (auto const& p : elt.second.view<std::shared_ptr<PropertySet>>()) {
+                h = detail::fingerprintMix(h + (p ? p->fingerprint() : NULL_SET_FINGERPRINT));
             }
-        } else {
-            std::shared_ptr<std::vector<std::any>> vp(new std::vector<std::any>(*(elt.second)));
-            n->_map[elt.first] = vp;
+            result += h;
         }
     }
-    return n;
+    return result;
+}
+
+std::shared_ptr<FrozenPropertySet const> PropertySet::freeze() const {
+    // The snapshot owns the only reference to its copy, so nothing can modify it
+    return std::shared_ptr<FrozenPropertySet const>(new FrozenPropertySet(deepCopy()));
+}
+
+std::shared_ptr<PropertySetSnapshot const> PropertySet::snapshot() const {
+    return std::shared_ptr<PropertySetSnapshot const>(new PropertySetSnapshot(*this));
 }
 
+// The aggregate counts walk the tree once, by pointer, without building
+// names; like names(), they descend only into the last of an array of sets.
+
 size_t PropertySet::nameCount(bool topLevelOnly) const {
-    int n = 0;
-    for (auto const& elt : _map) {
-        ++n;
-        if (!topLevelOnly && elt.second->back().type() == typeid(std::shared_ptr<PropertySet>)) {
-            auto p = std::any_cast<std::shared_ptr<PropertySet>>(elt.second->back());
-            if (p.get() != 0) {
+    size_t n = _map->size();
+    if (topLevelOnly || _nestedCount == 0) {
+        return n;
+    }
+    for (auto const& elt : *_map) {
+        if (elt.second.type() == Type::PropertySet) {
+            auto const& p = elt.second.view<std::shared_ptr<PropertySet>>().back();
+            if (p) {
                 n += p->nameCount(false);
             }
         }
@@ -99,14 +642,14 @@ size_t PropertySet::nameCount(bool topLevelOnly) const {
 
 std::vector<std::string> PropertySet::names(bool topLevelOnly) const {
     std::vector<std::string> v;
-    for (auto const& elt : _map) {
-        v.push_back(elt.first);
-        if (!topLevelOnly && elt.second->back().type() == typeid(std::shared_ptr<PropertySet>)) {
-            auto p = std::any_cast<std::shared_ptr<PropertySet>>(elt.second->back());
+    for (auto const& elt : *_map) {
+        v.push_back(elt.first.str());
+        if (!topLevelOnly && elt.second.type() == Type::PropertySet) {
+            auto p = elt.second.back<std::shared_ptr<PropertySet>>();
             if (p.get() != 0) {
                 std::vector<std::string> w = p->names(false);
                 for (auto const& k : w) {
-                    v.push_back(elt.first + "." + k);
+                    v.push_back(elt.first.str() + "." + k);
                 }
             }
         }
@@ -116,17 +659,17 @@ std::vector<std::string> PropertySet::names(bool topLevelOnly) const {
 
 std::vector<std::string> PropertySet::paramNames(bool topLevelOnly) const {
     std::vector<std::string> v;
-    for (auto const& elt : _map) {
-        if (elt.second->back().type() == typeid(std::shared_ptr<PropertySet>)) {
-            auto p = std::any_cast<std::shared_ptr<PropertySet>>(elt.second->back());
+    for (auto const& elt : *_map) {
+        if (elt.second.type() == Type::PropertySet) {
+            auto p = elt.second.back<std::shared_ptr<PropertySet>>();
             if (p.get() != 0 && !topLevelOnly) {
                 std::vector<std::string> w = p->paramNames(false);
                 for (auto const& k : w) {
-                    v.push_back(elt.first + "." + k);
+                    v.push_back(elt.first.str() + "." + k);
                 }
             }
         } else {
-            v.push_back(elt.first);
+            v.push_back(elt.first.str());
         }
     }
     return v;
@@ -134,14 +677,14 @@ std::vector<std::string> PropertySet::paramNames(bool topLevelOnly) const {
 
 std::vector<std::string> PropertySet::propertySetNames(bool topLevelOnly) const {
     std::vector<std::string> v;
-    for (auto const& elt : _map) {
-        if (elt.second->back().type() == typeid(std::shared_ptr<PropertySet>)) {
-            v.push_back(elt.first);
-            auto p = std::any_cast<std::shared_ptr<PropertySet>>(elt.second->back());
+    for (auto const& elt : *_map) {
+        if (elt.second.type() == Type::PropertySet) {
+            v.push_back(elt.first.str());
+            auto p = elt.second.back<std::shared_ptr<PropertySet>>();
             if (p.get() != 0 && !topLevelOnly) {
                 std::vector<std::string> w = p->propertySetNames(false);
                 for (auto const& k : w) {
-                    v.push_back(elt.first + "." + k);
+                    v.push_back(elt.first.str() + "." + k);
                 }
             }
         }
@@ -149,43 +692,52 @@ std::vector<std::string> PropertySet::propertySetNames(bool topLevelOnly) const
     return v;
 }
 
-bool PropertySet::exists(std::string const& name) const { return _find(name) != _map.end(); }
+PropertySet::EntryRange PropertySet::entries(bool topLevelOnly) const { return EntryRange(*this, topLevelOnly); }
+
+bool PropertySet::exists(std::string_view name) const { return _find(name) != nullptr; }
 
-bool PropertySet::isArray(std::string const& name) const {
+bool PropertySet::isArray(std::string_view name) const {
     auto const i = _find(name);
-    return i != _map.end() && i->second->size() > 1U;
+    return i != nullptr && i->second.size() > 1U;
 }
 
-bool PropertySet::isPropertySetPtr(std::string const& name) const {
+bool PropertySet::isPropertySetPtr(std::string_view name) const {
     auto const i = _find(name);
-    return i != _map.end() && i->second->back().type() == typeid(std::shared_ptr<PropertySet>);
+    return i != nullptr && i->second.type() == Type::PropertySet;
 }
 
-bool PropertySet::isUndefined(std::string const& name) const {
+bool PropertySet::isUndefined(std::string_view name) const {
     auto const i = _find(name);
-    return i != _map.end() && i->second->back().type() == typeid(nullptr);
+    return i != nullptr && i->second.type() == Type::Undef;
 }
 
 size_t PropertySet::valueCount() const {
     size_t sum = 0;
-    for (auto const& name : paramNames(false)) {
-        sum += valueCount(name);
+    for (auto const& elt : *_map) {
+        if (elt.second.type() == Type::PropertySet) {
+            auto const& p = elt.second.view<std::shared_ptr<PropertySet>>().back();
+            if (p) {
+                sum += p->valueCount();
+            }
+        } else {
+            sum += elt.second.size();
+        }
     }
     return sum;
 }
 
-size_t PropertySet::valueCount(std::string const& name) const {
+size_t PropertySet::valueCount(std::string_view name) const {
     auto const i = _find(name);
-    if (i == _map.end()) return 0;
-    return i->second->size();
+    if (i == nullptr) return 0;
+    return i->second.size();
 }
 
-std::type_info const& PropertySet::typeOf(std::string const& name) const {
+std::type_info const& PropertySet::typeOf(std::string_view name) const {
     auto const i = _find(name);
-    if (i == _map.end()) {
-        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
     }
-    return i->second->back().type();
+    return _typeOf(i->second);
 }
 
 template <typename T>
@@ -193,277 +745,282 @@ std::type_info const& PropertySet::typeOfT() {
     return typeid(T);
 }
 
+PropertySet::Type PropertySet::typeTag(std::string_view name) const {
+    auto const i = _find(name);
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
+    }
+    return i->second.type();
+}
+
+std::optional<PropertySet::Type> PropertySet::tryTypeTag(std::string_view name) const noexcept {
+    auto const i = _find(name);
+    if (i == nullptr) {
+        return std::nullopt;
+    }
+    return i->second.type();
+}
+
+std::type_info const* PropertySet::tryTypeOf(std::string_view name) const noexcept {
+    auto const i = _find(name);
+    if (i == nullptr) {
+        return nullptr;
+    }
+    return &_typeOf(i->second);
+}
+
+template <typename T>
+PropertySet::Type PropertySet::typeTagOfT() {
+    constexpr std::size_t index = TypeIndex<T, ValueTypes>::value;
+    static_assert(index < std::tuple_size<ValueTypes>::value, "Unsupported PropertySet value type");
+    return static_cast<Type>(index);
+}
+
 // The following throw an exception if the type does not match exactly.
 
 template <typename T>
-T PropertySet::get(std::string const& name)
+T PropertySet::get(std::string_view name)
         const { /* parasoft-suppress LsstDm-3-4a LsstDm-4-6 "allow template over bool" */
     auto const i = _find(name);
-    if (i == _map.end()) {
-        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
     }
-    try {
-        return std::any_cast<T>(i->second->back());
-    } catch (std::bad_any_cast &) {
-        std::throw_with_nested(LSST_EXCEPT(pex::exceptions::TypeError, name));
-    }
-    // not reached
-    return std::any_cast<T>(i->second->back());
+    return _back<T>(i->second, name);
 }
 
 template <typename T>
-T PropertySet::get(std::string const& name, T const& defaultValue)
+T PropertySet::get(std::string_view name, T const& defaultValue)
         const { /* parasoft-suppress LsstDm-3-4a LsstDm-4-6 "allow template over bool" */
     auto const i = _find(name);
-    if (i == _map.end()) {
+    if (i == nullptr) {
         return defaultValue;
     }
-    try {
-        return std::any_cast<T>(i->second->back());
-    } catch (std::bad_any_cast &) {
-        std::throw_with_nested(LSST_EXCEPT(pex::exceptions::TypeError, name));
+    return _back<T>(i->second, name);
+}
+
+template <typename T>
+std::vector<T> PropertySet::getArray(std::string_view name) const {
+    auto const i = _find(name);
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
     }
-    // not reached
-    return std::any_cast<T>(i->second->back());
+    return _toVector<T>(i->second, name);
 }
 
 template <typename T>
-std::vector<T> PropertySet::getArray(std::string const& name) const {
+std::optional<T> PropertySet::tryGet(std::string_view name) const {
     auto const i = _find(name);
-    if (i == _map.end()) {
-        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    if (i == nullptr || i->second.type() != typeTagOfT<T>()) {
+        return std::nullopt;
     }
-    std::vector<T> v;
-    for (auto const& j : *(i->second)) {
-        try {
-            v.push_back(std::any_cast<T>(j));
-        } catch (std::bad_any_cast &) {
-            std::throw_with_nested(LSST_EXCEPT(pex::exceptions::TypeError, name));
-        }
+    return i->second.back<T>();
+}
+
+template <typename T>
+std::optional<std::vector<T>> PropertySet::tryGetArray(std::string_view name) const {
+    auto const i = _find(name);
+    if (i == nullptr || i->second.type() != typeTagOfT<T>()) {
+        return std::nullopt;
     }
-    return v;
+    return i->second.toVector<T>();
+}
+
+template <typename T>
+PropertySet::ArrayView<T> PropertySet::getArrayView(std::string_view name) const {
+    auto const i = _find(name);
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
+    }
+    return _view<T>(i->second, name);
 }
 
+template <typename T>
+std::size_t PropertySet::getArrayInto(std::string_view name, T* buffer, std::size_t size) const {
+    ArrayView<T> const values = getArrayView<T>(name);
+    if (values.size() > size) {
+        throw LSST_EXCEPT(pex::exceptions::LengthError,
+                          std::string(name) + " has " + std::to_string(values.size()) +
+                                  " values, more than the buffer can hold");
+    }
+    std::copy(values.begin(), values.end(), buffer);
+    return values.size();
+}
+
+template <typename T>
+T PropertySet::get(Key<T> const& key) const {
+    auto const i = _find(key);
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, key.getName() + " not found");
+    }
+    if (i->second.type() != key.getType()) {
+        throw LSST_EXCEPT(pex::exceptions::TypeError, key.getName());
+    }
+    return i->second.template back<T>();
+}
+
+bool PropertySet::exists(Path const& path) const { return _find(path) != nullptr; }
+
 // The following throw an exception if the conversion is inappropriate.
 
-bool PropertySet::getAsBool(std::string const& name)
+bool PropertySet::getAsBool(std::string_view name)
         const { /* parasoft-suppress LsstDm-3-4a LsstDm-4-6 "for symmetry with other types" */
     return get<bool>(name);
 }
 
-int PropertySet::getAsInt(std::string const& name) const {
+int PropertySet::getAsInt(std::string_view name) const {
     auto const i = _find(name);
-    if (i == _map.end()) {
-        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
     }
-    std::any v = i->second->back();
-    std::type_info const& t = v.type();
-    if (t == typeid(bool)) {
-        return std::any_cast<bool>(v);
-    } else if (t == typeid(char)) {
-        return std::any_cast<char>(v);
-    } else if (t == typeid(signed char)) {
-        return std::any_cast<signed char>(v);
-    } else if (t == typeid(unsigned char)) {
-        return std::any_cast<unsigned char>(v);
-    } else if (t == typeid(short)) {
-        return std::any_cast<short>(v);
-    } else if (t == typeid(unsigned short)) {
-        return std::any_cast<unsigned short>(v);
-    }
-    try {
-        return std::any_cast<int>(v);
-    } catch (std::bad_any_cast &) {
-        std::throw_with_nested(LSST_EXCEPT(pex::exceptions::TypeError, name));
+    Values const& v = i->second;
+    switch (v.type()) {
+        case Type::Bool: return v.back<bool>();
+        case Type::Char: return v.back<char>();
+        case Type::SignedChar: return v.back<signed char>();
+        case Type::UnsignedChar: return v.back<unsigned char>();
+        case Type::Short: return v.back<short>();
+        case Type::UnsignedShort: return v.back<unsigned short>();
+        case Type::Int: return v.back<int>();
+        default: throw LSST_EXCEPT(pex::exceptions::TypeError, std::string(name));
     }
-    // not reached
-    return std::any_cast<int>(v);
 }
 
-int64_t PropertySet::getAsInt64(std::string const& name) const {
+int64_t PropertySet::getAsInt64(std::string_view name) const {
     auto const i = _find(name);
-    if (i == _map.end()) {
-        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
     }
-    std::any v = i->second->back();
-    std::type_info const& t = v.type();
-    if (t == typeid(bool)) return std::any_cast<bool>(v);
-    if (t == typeid(char)) return std::any_cast<char>(v);
-    if (t == typeid(signed char)) return std::any_cast<signed char>(v);
-    if (t == typeid(unsigned char)) return std::any_cast<unsigned char>(v);
-    if (t == typeid(short)) return std::any_cast<short>(v);
-    if (t == typeid(unsigned short)) return std::any_cast<unsigned short>(v);
-    if (t == typeid(int)) return std::any_cast<int>(v);
-    if (t == typeid(unsigned int)) return std::any_cast<unsigned int>(v);
-    if (t == typeid(long)) return std::any_cast<long>(v);
-    if (t == typeid(long long)) return std::any_cast<long long>(v);
-    try {
-        return std::any_cast<int64_t>(v);
-    } catch (std::bad_any_cast &) {
-        std::throw_with_nested(LSST_EXCEPT(pex::exceptions::TypeError, name));
+    Values const& v = i->second;
+    switch (v.type()) {
+        case Type::Bool: return v.back<bool>();
+        case Type::Char: return v.back<char>();
+        case Type::SignedChar: return v.back<signed char>();
+        case Type::UnsignedChar: return v.back<unsigned char>();
+        case Type::Short: return v.back<short>();
+        case Type::UnsignedShort: return v.back<unsigned short>();
+        case Type::Int: return v.back<int>();
+        case Type::UnsignedInt: return v.back<unsigned int>();
+        case Type::Long: return v.back<long>();
+        case Type::LongLong: return v.back<long long>();
+        default: throw LSST_EXCEPT(pex::exceptions::TypeError, std::string(name));
     }
-    // not reached
-    return std::any_cast<int64_t>(v);
 }
 
-uint64_t PropertySet::getAsUInt64(std::string const& name) const {
+uint64_t PropertySet::getAsUInt64(std::string_view name) const {
     auto const i = _find(name);
-    if (i == _map.end()) {
-        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
     }
-    std::any v = i->second->back();
-    std::type_info const& t = v.type();
-    if (t == typeid(bool)) return std::any_cast<bool>(v);
-    if (t == typeid(char)) return std::any_cast<char>(v);
-    if (t == typeid(signed char)) return std::any_cast<signed char>(v);
-    if (t == typeid(unsigned char)) return std::any_cast<unsigned char>(v);
-    if (t == typeid(short)) return std::any_cast<short>(v);
-    if (t == typeid(unsigned short)) return std::any_cast<unsigned short>(v);
-    if (t == typeid(int)) return std::any_cast<int>(v);
-    if (t == typeid(unsigned int)) return std::any_cast<unsigned int>(v);
-    if (t == typeid(long)) return std::any_cast<long>(v);
-    if (t == typeid(long long)) return std::any_cast<long long>(v);
-    if (t == typeid(unsigned long long)) return std::any_cast<unsigned long long>(v);
-    try {
-        return std::any_cast<uint64_t>(v);
-    } catch (std::bad_any_cast &) {
-        std::throw_with_nested(LSST_EXCEPT(pex::exceptions::TypeError, name));
+    Values const& v = i->second;
+    switch (v.type()) {
+        case Type::Bool: return v.back<bool>();
+        case Type::Char: return v.back<char>();
+        case Type::SignedChar: return v.back<signed char>();
+        case Type::UnsignedChar: return v.back<unsigned char>();
+        case Type::Short: return v.back<short>();
+        case Type::UnsignedShort: return v.back<unsigned short>();
+        case Type::Int: return v.back<int>();
+        case Type::UnsignedInt: return v.back<unsigned int>();
+        case Type::Long: return v.back<long>();
+        case Type::UnsignedLong: return v.back<unsigned long>();
+        case Type::LongLong: return v.back<long long>();
+        case Type::UnsignedLongLong: return v.back<unsigned long long>();
+        default: throw LSST_EXCEPT(pex::exceptions::TypeError, std::string(name));
     }
-    // not reached
-    return std::any_cast<uint64_t>(v);
 }
 
-double PropertySet::getAsDouble(std::string const& name) const {
+double PropertySet::getAsDouble(std::string_view name) const {
     auto const i = _find(name);
-    if (i == _map.end()) {
-        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
     }
-    std::any v = i->second->back();
-    std::type_info const& t = v.type();
-    if (t == typeid(bool)) return std::any_cast<bool>(v);
-    if (t == typeid(char)) return std::any_cast<char>(v);
-    if (t == typeid(signed char)) return std::any_cast<signed char>(v);
-    if (t == typeid(unsigned char)) return std::any_cast<unsigned char>(v);
-    if (t == typeid(short)) return std::any_cast<short>(v);
-    if (t == typeid(unsigned short)) return std::any_cast<unsigned short>(v);
-    if (t == typeid(int)) return std::any_cast<int>(v);
-    if (t == typeid(unsigned int)) return std::any_cast<unsigned int>(v);
-    if (t == typeid(long)) return std::any_cast<long>(v);
-    if (t == typeid(unsigned long)) return std::any_cast<unsigned long>(v);
-    if (t == typeid(long long)) return std::any_cast<long long>(v);
-    if (t == typeid(unsigned long long)) return std::any_cast<unsigned long long>(v);
-    if (t == typeid(float)) return std::any_cast<float>(v);
-    try {
-        return std::any_cast<double>(v);
-    } catch (std::bad_any_cast &) {
-        std::throw_with_nested(LSST_EXCEPT(pex::exceptions::TypeError, name));
+    Values const& v = i->second;
+    switch (v.type()) {
+        case Type::Bool: return v.back<bool>();
+        case Type::Char: return v.back<char>();
+        case Type::SignedChar: return v.back<signed char>();
+        case Type::UnsignedChar: return v.back<unsigned char>();
+        case Type::Short: return v.back<short>();
+        case Type::UnsignedShort: return v.back<unsigned short>();
+        case Type::Int: return v.back<int>();
+        case Type::UnsignedInt: return v.back<unsigned int>();
+        case Type::Long: return v.back<long>();
+        case Type::UnsignedLong: return v.back<unsigned long>();
+        case Type::LongLong: return v.back<long long>();
+        case Type::UnsignedLongLong: return v.back<unsigned long long>();
+        case Type::Float: return v.back<float>();
+        case Type::Double: return v.back<double>();
+        default: throw LSST_EXCEPT(pex::exceptions::TypeError, std::string(name));
     }
-    // not reached
-    return std::any_cast<double>(v);
 }
 
-std::string PropertySet::getAsString(std::string const& name) const { return get<std::string>(name); }
+std::string PropertySet::getAsString(std::string_view name) const { return get<std::string>(name); }
 
-std::shared_ptr<PropertySet> PropertySet::getAsPropertySetPtr(std::string const& name) const {
+std::shared_ptr<PropertySet> PropertySet::getAsPropertySetPtr(std::string_view name) const {
     return get<std::shared_ptr<PropertySet>>(name);
 }
 
-Persistable::Ptr PropertySet::getAsPersistablePtr(std::string const& name) const {
+Persistable::Ptr PropertySet::getAsPersistablePtr(std::string_view name) const {
     return get<Persistable::Ptr>(name);
 }
 
 std::string PropertySet::toString(bool topLevelOnly, std::string const& indent) const {
-    std::ostringstream s;
-    std::vector<std::string> nv = names();
-    sort(nv.begin(), nv.end());
-    for (auto const& i : nv) {
-        std::shared_ptr<std::vector<std::any>> vp = _map.find(i)->second;
-        std::type_info const& t = vp->back().type();
-        if (t == typeid(std::shared_ptr<PropertySet>)) {
-            s << indent << i << " = ";
+    std::string out;
+    _write(out, topLevelOnly, indent);
+    return out;
+}
+
+void PropertySet::_write(std::string& out, bool topLevelOnly, std::string const& indent) const {
+    // Sort the entries themselves, rather than copies of their names
+    std::vector<AnyMap::value_type const*> entries;
+    entries.reserve(_map->size());
+    for (auto const& elt : *_map) {
+        entries.push_back(&elt);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](auto const* a, auto const* b) { return a->first.view() < b->first.view(); });
+    for (auto const* elt : entries) {
+        Values const& vp = elt->second;
+        if (vp.type() == Type::PropertySet) {
+            ((out += indent) += elt->first.view()) += " = ";
             if (topLevelOnly) {
-                s << "{ ... }";
+                out += "{ ... }";
             } else {
-                auto p = std::any_cast<std::shared_ptr<PropertySet>>(vp->back());
-                if (p.get() == 0) {
-                    s << "{ NULL }";
+                auto const& p = vp.view<std::shared_ptr<PropertySet>>().back();
+                if (!p) {
+                    out += "{ NULL }";
                 } else {
-                    s << '{' << std::endl;
-                    s << p->toString(false, indent + "..");
-                    s << indent << '}';
+                    out += "{\n";
+                    p->_write(out, false, indent + "..");
+                    (out += indent) += '}';
                 }
             }
-            s << std::endl;
+            out += '\n';
         } else {
-            s << indent << _format(i);
+            out += indent;
+            _format(out, elt->first.view());
         }
     }
-    return s.str();
 }
 
-std::string PropertySet::_format(std::string const& name) const {
-    std::ostringstream s;
-    s << std::showpoint;  // Always show a decimal point for floats
-    auto const j = _map.find(name);
-    s << j->first << " = ";
-    std::shared_ptr<std::vector<std::any>> vp = j->second;
-    if (vp->size() > 1) {
-        s << "[ ";
-    }
-    std::type_info const& t = vp->back().type();
-    bool isFirst = true;
-    for (auto const& k : *vp) {
-        if (isFirst) {
-            isFirst = false;
-        } else {
-            s << ", ";
-        }
-        std::any const& v(k);
-        if (t == typeid(bool)) {
-            s << std::any_cast<bool>(v);
-        } else if (t == typeid(char)) {
-            s << '\'' << std::any_cast<char>(v) << '\'';
-        } else if (t == typeid(signed char)) {
-            s << '\'' << std::any_cast<signed char>(v) << '\'';
-        } else if (t == typeid(unsigned char)) {
-            s << '\'' << std::any_cast<unsigned char>(v) << '\'';
-        } else if (t == typeid(short)) {
-            s << std::any_cast<short>(v);
-        } else if (t == typeid(unsigned short)) {
-            s << std::any_cast<unsigned short>(v);
-        } else if (t == typeid(int)) {
-            s << std::any_cast<int>(v);
-        } else if (t == typeid(unsigned int)) {
-            s << std::any_cast<unsigned int>(v);
-        } else if (t == typeid(long)) {
-            s << std::any_cast<long>(v);
-        } else if (t == typeid(unsigned long)) {
-            s << std::any_cast<unsigned long>(v);
-        } else if (t == typeid(long long)) {
-            s << std::any_cast<long long>(v);
-        } else if (t == typeid(unsigned long long)) {
-            s << std::any_cast<unsigned long long>(v);
-        } else if (t == typeid(float)) {
-            s << std::setprecision(7) << std::any_cast<float>(v);
-        } else if (t == typeid(double)) {
-            s << std::setprecision(14) << std::any_cast<double>(v);
-        } else if (t == typeid(std::string)) {
-            s << '"' << std::any_cast<std::string>(v) << '"';
-        } else if (t == typeid(DateTime)) {
-            s << std::any_cast<DateTime>(v).toString(DateTime::UTC);
-        } else if (t == typeid(std::shared_ptr<PropertySet>)) {
-            s << "{ ... }";
-        } else if (t == typeid(Persistable::Ptr)) {
-            s << "<Persistable>";
-        } else {
-            s << "<Unknown>";
+void PropertySet::_format(std::string& out, std::string_view name) const {
+    auto const j = _map->find(name);
+    (out += j->first.view()) += " = ";
+    j->second.visit([&out](auto const* data, std::size_t n) {
+        if (n > 1) {
+            out += "[ ";
         }
-    }
-    if (j->second->size() > 1) {
-        s << " ]";
-    }
-    s << std::endl;
-    return s.str();
+        for (std::size_t k = 0; k < n; ++k) {
+            if (k > 0) {
+                out += ", ";
+            }
+            _formatValue(out, data[k]);
+        }
+        if (n > 1) {
+            out += " ]";
+        }
+    });
+    out += '\n';
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -472,31 +1029,60 @@ std::string PropertySet::_format(std::string const& name) const {
 
 template <typename T>
 void PropertySet::set(std::string const& name, T const& value) {
-    std::shared_ptr<std::vector<std::any>> vp(new std::vector<std::any>);
-    vp->push_back(value);
-    _set(name, vp);
+    _set(name, Values(value, _resource()));
 }
 
 template <typename T>
 void PropertySet::set(std::string const& name, std::vector<T> const& value) {
     if (value.empty()) return;
-    std::shared_ptr<std::vector<std::any>> vp(new std::vector<std::any>);
-    _append(*vp, value);
-    _set(name, vp);
+    _set(name, Values(value, _resource()));
+}
+
+template <typename T>
+void PropertySet::set(std::string const& name, std::vector<T>&& value) {
+    if (value.empty()) return;
+    _set(name, Values(std::move(value), _resource()));
+}
+
+void PropertySet::set(std::string const& name, std::string&& value) {
+    _set(name, Values(std::move(value), _resource()));
 }
 
 void PropertySet::set(std::string const& name, char const* value) { set(name, std::string(value)); }
 
+template <typename T>
+void PropertySet::set(Key<T> const& key, typename Key<T>::Value const& value) {
+    if constexpr (!std::is_same<T, std::shared_ptr<PropertySet>>::value) {
+        // Replacing values of the same type changes neither the hierarchy nor
+        // the order of a PropertyList, so it needs no help from _set
+        PropertySet* owner;
+        auto const i = _find(key, &owner);
+        if (i != nullptr && i->second.type() == key.getType()) {
+            Values values(value, owner->_resource());
+            std::string_view const leaf = i->first.view();
+            owner->_fingerprint += _contribution(leaf, values) - _contribution(leaf, i->second);
+            i->second = std::move(values);
+            _record(Change::Kind::Set, key.getName());
+            return;
+        }
+    }
+    set(key.getName(), value);
+}
+
 template <typename T>
 void PropertySet::add(std::string const& name, T const& value) {
-    AnyMap::iterator i = _find(name);
-    if (i == _map.end()) {
+    PropertySet* owner;
+    AnyMap::value_type* const i = _find(name, &owner);
+    if (i == nullptr) {
         set(name, value);
     } else {
-        if (i->second->back().type() != typeid(T)) {
+        if (i->second.type() != typeTagOfT<T>()) {
             throw LSST_EXCEPT(pex::exceptions::TypeError, name + " has mismatched type");
         }
-        i->second->push_back(value);
+        std::size_t const n = i->second.size();
+        i->second.append(value, owner->_resource());
+        owner->_appended(*i, n);
+        _record(Change::Kind::Add, name);
     }
 }
 
@@ -506,28 +1092,36 @@ void PropertySet::add<std::shared_ptr<PropertySet>>(
     std::string const& name,
     std::shared_ptr<PropertySet> const& value
 ) {
-    AnyMap::iterator i = _find(name);
-    if (i == _map.end()) {
+    PropertySet* owner;
+    AnyMap::value_type* const i = _find(name, &owner);
+    if (i == nullptr) {
         set(name, value);
     } else {
-        if (i->second->back().type() != typeid(std::shared_ptr<PropertySet>)) {
+        if (i->second.type() != typeTagOfT<std::shared_ptr<PropertySet>>()) {
             throw LSST_EXCEPT(pex::exceptions::TypeError, name + " has mismatched type");
         }
         _cycleCheckPtr(value, name);
-        i->second->push_back(value);
+        std::size_t const n = i->second.size();
+        i->second.append(value, owner->_resource());
+        owner->_appended(*i, n);
+        _record(Change::Kind::Add, name);
     }
 }
 
 template <typename T>
 void PropertySet::add(std::string const& name, std::vector<T> const& value) {
-    AnyMap::iterator i = _find(name);
-    if (i == _map.end()) {
+    PropertySet* owner;
+    AnyMap::value_type* const i = _find(name, &owner);
+    if (i == nullptr) {
         set(name, value);
     } else {
-        if (i->second->back().type() != typeid(T)) {
+        if (i->second.type() != typeTagOfT<T>()) {
             throw LSST_EXCEPT(pex::exceptions::TypeError, name + " has mismatched type");
         }
-        _append(*(i->second), value);
+        std::size_t const n = i->second.size();
+        i->second.append(value, owner->_resource());
+        owner->_appended(*i, n);
+        _record(Change::Kind::Add, name);
     }
 }
 
@@ -537,20 +1131,104 @@ void PropertySet::add<std::shared_ptr<PropertySet>>(
     std::string const& name,
     std::vector<std::shared_ptr<PropertySet>> const& value
 ) {
-    AnyMap::iterator i = _find(name);
-    if (i == _map.end()) {
+    PropertySet* owner;
+    AnyMap::value_type* const i = _find(name, &owner);
+    if (i == nullptr) {
         set(name, value);
     } else {
-        if (i->second->back().type() != typeid(std::shared_ptr<PropertySet>)) {
+        if (i->second.type() != typeTagOfT<std::shared_ptr<PropertySet>>()) {
+            throw LSST_EXCEPT(pex::exceptions::TypeError, name + " has mismatched type");
+        }
+        _cycleCheckPtrVec(ArrayView<std::shared_ptr<PropertySet>>(value.data(), value.size()), name);
+        std::size_t const n = i->second.size();
+        i->second.append(value, owner->_resource());
+        owner->_appended(*i, n);
+        _record(Change::Kind::Add, name);
+    }
+}
+
+template <typename T>
+void PropertySet::add(std::string const& name, std::vector<T>&& value) {
+    PropertySet* owner;
+    AnyMap::value_type* const i = _find(name, &owner);
+    if (i == nullptr) {
+        set(name, std::move(value));
+    } else {
+        if (i->second.type() != typeTagOfT<T>()) {
+            throw LSST_EXCEPT(pex::exceptions::TypeError, name + " has mismatched type");
+        }
+        if constexpr (std::is_same<T, std::shared_ptr<PropertySet>>::value) {
+            _cycleCheckPtrVec(ArrayView<std::shared_ptr<PropertySet>>(value.data(), value.size()), name);
+        }
+        std::size_t const n = i->second.size();
+        i->second.append(std::move(value), owner->_resource());
+        owner->_appended(*i, n);
+        _record(Change::Kind::Add, name);
+    }
+}
+
+void PropertySet::add(std::string const& name, std::string&& value) {
+    PropertySet* owner;
+    AnyMap::value_type* const i = _find(name, &owner);
+    if (i == nullptr) {
+        set(name, std::move(value));
+    } else {
+        if (i->second.type() != Type::String) {
             throw LSST_EXCEPT(pex::exceptions::TypeError, name + " has mismatched type");
         }
-        _cycleCheckPtrVec(value, name);
-        _append(*(i->second), value);
+        std::size_t const n = i->second.size();
+        i->second.append(std::move(value), owner->_resource());
+        owner->_appended(*i, n);
+        _record(Change::Kind::Add, name);
     }
 }
 
 void PropertySet::add(std::string const& name, char const* value) { add(name, std::string(value)); }
 
+void PropertySet::reserve(std::string const& name, std::size_t n) {
+    PropertySet* owner;
+    AnyMap::value_type* const i = _find(name, &owner);
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    }
+    i->second.reserve(n, owner->_resource());
+}
+
+void PropertySet::reserve(std::size_t n) { _map.write().reserve(n); }
+
+void PropertySet::setAll(std::vector<Item> items) {
+    reserve(_map->size() + items.size());
+    for (auto& item : items) {
+        if (_isTopLevel(item)) {
+            _setTopLevel(item._name, std::move(item._values));
+        } else if (!item._empty) {
+            _set(item._name, std::move(item._values));
+        }
+    }
+}
+
+void PropertySet::setJournaling(bool enable) {
+    if (!enable) {
+        _journal.reset();
+    } else if (!_journal) {
+        _journal = std::make_unique<std::vector<Change>>();
+    }
+}
+
+std::vector<PropertySet::Change> const& PropertySet::getJournal() const noexcept {
+    static std::vector<Change> const empty;
+    return _journal ? *_journal : empty;
+}
+
+std::vector<PropertySet::Change> PropertySet::takeJournal() {
+    if (!_journal) {
+        return {};
+    }
+    std::vector<Change> result;
+    result.swap(*_journal);
+    return result;
+}
+
 void PropertySet::copy(
     std::string const& dest,
     PropertySet const& source,
@@ -558,18 +1236,13 @@ void PropertySet::copy(
     bool asScalar
 ) {
     auto const sj = source._find(name);
-    if (sj == source._map.end()) {
+    if (sj == nullptr) {
         throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, name + " not in source");
     }
+    // Take the values before removing dest: erasing from the map may move the source entry
+    Values values = asScalar ? sj->second.lastOnly(_resource()) : sj->second;
     remove(dest);
-    if (asScalar) {
-        auto vp = std::make_shared<std::vector<std::any>>();
-        vp->push_back(sj->second->back());
-        _set(dest, vp);
-    } else {
-        auto vp = std::make_shared<std::vector<std::any>>(*(sj->second));
-        _set(dest, vp);
-    }
+    _set(dest, std::move(values));
 }
 
 
@@ -581,22 +1254,61 @@ void PropertySet::combine(PropertySet const & source) {
     }
 }
 
+void PropertySet::combine(PropertySet&& source) {
+    std::vector<std::string> names = source.paramNames(false);
+    // Values held directly by source can be moved; nested PropertySets may
+    // be shared with other owners, so their values are copied
+    auto const held = [&source](std::string const& name) {
+        return source._flat || name.find('.') == std::string::npos;
+    };
+    std::size_t done = 0;
+    try {
+        for (; done < names.size(); ++done) {
+            std::string const& name = names[done];
+            if (held(name)) {
+                auto const sp = source._map.write().find(name);
+                // Values _add would reject are copied, so that they survive its exception
+                if (_accepts(name, sp->second)) {
+                    _add(name, std::move(sp->second));
+                } else {
+                    _add(name, sp->second);
+                }
+            } else {
+                auto const sp = static_cast<PropertySet const&>(source)._find(name);
+                _add(name, sp->second);
+            }
+        }
+    } catch (...) {
+        // Drop what was moved out, leaving a valid cell for _remove to read
+        for (std::size_t k = 0; k < done; ++k) {
+            if (held(names[k])) {
+                source._map.write().find(names[k])->second = Values(nullptr);
+                source._remove(names[k]);
+            }
+        }
+        source._rehash();
+        throw;
+    }
+    source._map.reset();
+    source._fingerprint = 0;
+    source._nestedCount = 0;
+}
+
 
 void PropertySet::remove(std::string const& name) {
-    std::string::size_type i = name.find('.');
-    if (_flat || i == name.npos) {
-        _map.erase(name);
-        return;
+    if (_remove(name)) {
+        _record(Change::Kind::Remove, name);
     }
-    std::string prefix(name, 0, i);
-    AnyMap::iterator j = _map.find(prefix);
-    if (j == _map.end() || j->second->back().type() != typeid(std::shared_ptr<PropertySet>)) {
-        return;
-    }
-    auto p = std::any_cast<std::shared_ptr<PropertySet>>(j->second->back());
-    if (p.get() != 0) {
-        std::string suffix(name, i + 1);
-        p->remove(suffix);
+}
+
+void PropertySet::apply(PropertySetPatch const& patch) {
+    PropertySet const& values = patch.getValues();
+    for (auto const& edit : patch.getEdits()) {
+        if (edit.kind == PropertySetPatch::Edit::Kind::Remove) {
+            remove(edit.name);
+        } else {
+            _set(edit.name, _isolate(values._map->find(edit.name)->second, _resource()));
+        }
     }
 }
 
@@ -604,143 +1316,561 @@ void PropertySet::remove(std::string const& name) {
 // Private member functions
 ///////////////////////////////////////////////////////////////////////////////
 
-PropertySet::AnyMap::iterator PropertySet::_find(std::string const& name) {
-    std::string::size_type i = name.find('.');
+bool PropertySet::_remove(std::string_view name) {
+    // Look up through the shared maps, so that removing a missing name changes nothing
+    std::string_view::size_type i = name.find('.');
     if (_flat || i == name.npos) {
-        return _map.find(name);
+        auto const j = _map->find(name);
+        if (j == _map->end()) {
+            return false;
+        }
+        _fingerprint -= _contribution(name, j->second);
+        _nestedCount -= j->second.type() == Type::PropertySet;
+        _map.write().erase(name);
+        return true;
     }
-    std::string prefix(name, 0, i);
-    AnyMap::iterator j = _map.find(prefix);
-    if (j == _map.end() || j->second->back().type() != typeid(std::shared_ptr<PropertySet>)) {
-        return _map.end();
+    auto const j = _map->find(name.substr(0, i));
+    if (j == _map->end() || j->second.type() != Type::PropertySet) {
+        return false;
     }
-    auto p = std::any_cast<std::shared_ptr<PropertySet>>(j->second->back());
-    if (p.get() == 0) {
-        return _map.end();
+    PropertySet* p = j->second.back<std::shared_ptr<PropertySet>>().get();
+    return p != 0 && p->_remove(name.substr(i + 1));
+}
+
+// Walk down one level per dot-separated component of the name; the
+// components are views into the name, so no strings are built.
+
+PropertySet::AnyMap::value_type* PropertySet::_find(std::string_view name, PropertySet** owner) {
+    // Walk the maps as they are; only the one holding the property is
+    // unshared, since the result may be used to modify the property
+    PropertySet* p = this;
+    std::string_view::size_type i;
+    while (!p->_flat && (i = name.find('.')) != name.npos) {
+        auto const j = p->_map->find(name.substr(0, i));
+        if (j == p->_map->end() || j->second.type() != Type::PropertySet) {
+            return nullptr;
+        }
+        // The pointee stays owned by the map entry
+        p = j->second.back<std::shared_ptr<PropertySet>>().get();
+        if (p == 0) {
+            return nullptr;
+        }
+        name.remove_prefix(i + 1);
     }
-    std::string suffix(name, i + 1);
-    AnyMap::iterator x = p->_find(suffix);
-    if (x == p->_map.end()) {
-        return _map.end();
+    AnyMap::value_type* const x = p->_findLocal(name, AnyMap::hash(name));
+    if (owner) {
+        *owner = p;
     }
     return x;
 }
 
-PropertySet::AnyMap::const_iterator PropertySet::_find(std::string const& name) const {
-    std::string::size_type i = name.find('.');
-    if (_flat || i == name.npos) {
-        return _map.find(name);
+PropertySet::AnyMap::value_type const* PropertySet::_find(std::string_view name) const {
+    PropertySet const* p = this;
+    std::string_view::size_type i;
+    while (!p->_flat && (i = name.find('.')) != name.npos) {
+        auto const j = p->_map->find(name.substr(0, i));
+        if (j == p->_map->end() || j->second.type() != Type::PropertySet) {
+            return nullptr;
+        }
+        p = j->second.back<std::shared_ptr<PropertySet>>().get();
+        if (p == 0) {
+            return nullptr;
+        }
+        name.remove_prefix(i + 1);
     }
-    std::string prefix(name, 0, i);
-    auto const j = _map.find(prefix);
-    if (j == _map.end() || j->second->back().type() != typeid(std::shared_ptr<PropertySet>)) {
-        return _map.end();
+    auto const x = p->_map->find(name);
+    if (x == p->_map->end()) {
+        return nullptr;
     }
-    auto p = std::any_cast<std::shared_ptr<PropertySet>>(j->second->back());
-    if (p.get() == 0) {
-        return _map.end();
+    return &*x;
+}
+
+// As above, but with the components and their hashes precomputed.  A flat
+// set below the top level holds the rest of the name as a single key.
+
+PropertySet::AnyMap::value_type* PropertySet::_find(Path const& path, PropertySet** owner) {
+    std::string_view const name(path._name);
+    if (owner) {
+        *owner = this;
     }
-    std::string suffix(name, i + 1);
-    auto const x = p->_find(suffix);
-    if (x == p->_map.end()) {
-        return _map.end();
+    if (_flat) {
+        return _findLocal(name, path._hash);
     }
-    return x;
+    PropertySet* p = this;
+    std::size_t const last = path._segments.size() - 1;
+    for (std::size_t k = 0; k < last; ++k) {
+        Path::Segment const& segment = path._segments[k];
+        auto const j = p->_map->find(name.substr(segment.begin, segment.size), segment.hash);
+        if (j == p->_map->end() || j->second.type() != Type::PropertySet) {
+            return nullptr;
+        }
+        p = j->second.back<std::shared_ptr<PropertySet>>().get();
+        if (p == 0) {
+            return nullptr;
+        }
+        if (owner) {
+            *owner = p;
+        }
+        if (p->_flat) {
+            std::string_view const rest = name.substr(path._segments[k + 1].begin);
+            return p->_findLocal(rest, AnyMap::hash(rest));
+        }
+    }
+    Path::Segment const& segment = path._segments[last];
+    return p->_findLocal(name.substr(segment.begin, segment.size), segment.hash);
+}
+
+PropertySet::AnyMap::value_type* PropertySet::_findLocal(std::string_view key, std::size_t keyHash) {
+    // An empty map may have no storage yet, which writing would allocate
+    if (_map->empty() || (_map.isShared() && _map->find(key, keyHash) == _map->end())) {
+        return nullptr;
+    }
+    AnyMap& map = _map.write();
+    AnyMap::iterator const x = map.find(key, keyHash);
+    return x == map.end() ? nullptr : &*x;
 }
 
-void PropertySet::_set(std::string const& name, std::shared_ptr<std::vector<std::any>> vp) {
-    _findOrInsert(name, vp);
+// Follows the checks of _add and _findOrInsert, which create any sets
+// missing from a hierarchical name.
+
+bool PropertySet::_accepts(std::string_view name, Values const& values) const {
+    if (values.type() == Type::PropertySet) {
+        return false;
+    }
+    PropertySet const* p = this;
+    std::string_view::size_type i;
+    while (!p->_flat && (i = name.find('.')) != name.npos) {
+        auto const j = p->_map->find(name.substr(0, i));
+        if (j == p->_map->end()) {
+            return true;
+        }
+        if (j->second.type() != Type::PropertySet) {
+            return false;
+        }
+        p = j->second.back<std::shared_ptr<PropertySet>>().get();
+        if (p == 0) {
+            return false;
+        }
+        name.remove_prefix(i + 1);
+    }
+    auto const x = p->_map->find(name);
+    return x == p->_map->end() || x->second.type() == values.type();
+}
+
+PropertySet::AnyMap::value_type const* PropertySet::_find(Path const& path) const {
+    std::string_view const name(path._name);
+    if (_flat) {
+        auto const x = _map->find(name, path._hash);
+        return x == _map->end() ? nullptr : &*x;
+    }
+    PropertySet const* p = this;
+    std::size_t const last = path._segments.size() - 1;
+    for (std::size_t k = 0; k < last; ++k) {
+        Path::Segment const& segment = path._segments[k];
+        auto const j = p->_map->find(name.substr(segment.begin, segment.size), segment.hash);
+        if (j == p->_map->end() || j->second.type() != Type::PropertySet) {
+            return nullptr;
+        }
+        p = j->second.back<std::shared_ptr<PropertySet>>().get();
+        if (p == 0) {
+            return nullptr;
+        }
+        if (p->_flat) {
+            auto const x = p->_map->find(name.substr(path._segments[k + 1].begin));
+            return x == p->_map->end() ? nullptr : &*x;
+        }
+    }
+    Path::Segment const& segment = path._segments[last];
+    auto const x = p->_map->find(name.substr(segment.begin, segment.size), segment.hash);
+    if (x == p->_map->end()) {
+        return nullptr;
+    }
+    return &*x;
+}
+
+void PropertySet::_deepCopyFrom(PropertySet const& source) {
+    bool const hasSets = std::any_of(source._map->begin(), source._map->end(), [](auto const& elt) {
+        return elt.second.type() == Type::PropertySet;
+    });
+    if (!hasSets) {
+        // Share the storage until either set is modified
+        _map = source._map;
+        _fingerprint = source._fingerprint;
+        return;
+    }
+    _map.write().reserve(source._map->size());
+    _mergeCopyFrom(source);
+}
+
+void PropertySet::_mergeCopyFrom(PropertySet const& source) {
+    // Nested sets must be copied, since they may be modified through other pointers
+    AnyMap& map = _map.write();
+    for (auto const& elt : *source._map) {
+        if (elt.second.type() == Type::PropertySet) {
+            for (auto const& p : elt.second.toVector<std::shared_ptr<PropertySet>>()) {
+                if (p.get() == 0) {
+                    add(elt.first.str(), std::shared_ptr<PropertySet>());
+                } else {
+                    add(elt.first.str(), p->deepCopy());
+                }
+            }
+        } else {
+            map.emplace(elt.first, elt.second);
+        }
+    }
+    // The adds above counted the nested sets, which contribute nothing to _fingerprint
+    _fingerprint += source._fingerprint;
+}
+
+bool PropertySet::_isTopLevel(Item const& item) const {
+    return !item._empty && item._values.type() != Type::PropertySet &&
+           (_flat || item._name.find('.') == std::string::npos);
 }
 
-void PropertySet::_add(std::string const& name, std::shared_ptr<std::vector<std::any>> vp) {
-    auto const dp = _find(name);
-    if (dp == _map.end()) {
-        _set(name, vp);
+bool PropertySet::_setTopLevel(std::string const& name, Values values) {
+    bool const inserted = _store(name, std::move(values));
+    _record(Change::Kind::Set, name);
+    return inserted;
+}
+
+void PropertySet::_set(std::string const& name, Values values) {
+    // A flat set records the names a PropertySet is flattened into instead
+    bool const flattened = _flat && values.type() == Type::PropertySet;
+    _findOrInsert(name, std::move(values));
+    if (!flattened) {
+        _record(Change::Kind::Set, name);
+    }
+}
+
+void PropertySet::_add(std::string const& name, Values values) {
+    PropertySet* owner;
+    auto const dp = _find(name, &owner);
+    if (dp == nullptr) {
+        _set(name, std::move(values));
     } else {
-        if (vp->back().type() != dp->second->back().type()) {
+        if (values.type() != dp->second.type()) {
             throw LSST_EXCEPT(pex::exceptions::TypeError, name + " has mismatched type");
         }
         // Check for cycles
-        if (vp->back().type() == typeid(std::shared_ptr<PropertySet>)) {
-            _cycleCheckAnyVec(*vp, name);
+        if (values.type() == Type::PropertySet) {
+            _cycleCheckPtrVec(values.view<std::shared_ptr<PropertySet>>(), name);
         }
-        _append(*(dp->second), *vp);
+        std::size_t const n = dp->second.size();
+        dp->second.append(std::move(values), owner->_resource());
+        owner->_appended(*dp, n);
+        _record(Change::Kind::Add, name);
     }
 }
 
-void PropertySet::_findOrInsert(std::string const& name, std::shared_ptr<std::vector<std::any>> vp) {
-    if (vp->back().type() == typeid(std::shared_ptr<PropertySet>)) {
+void PropertySet::_findOrInsert(std::string_view name, Values values) {
+    if (values.type() == Type::PropertySet) {
         if (_flat) {
-            auto source = std::any_cast<std::shared_ptr<PropertySet>>(vp->back());
+            std::shared_ptr<PropertySet const> source = values.back<std::shared_ptr<PropertySet>>();
             std::vector<std::string> names = source->paramNames(false);
+            std::string const prefix = std::string(name) + ".";
             for (auto const& i : names) {
                 auto const sp = source->_find(i);
-                _add(name + "." + i, sp->second);
+                _add(prefix + i, sp->second);
             }
             return;
         }
 
         // Check for cycles
-        _cycleCheckAnyVec(*vp, name);
+        _cycleCheckPtrVec(values.view<std::shared_ptr<PropertySet>>(), name);
     }
 
-    std::string::size_type i = name.find('.');
+    std::string_view::size_type i = name.find('.');
     if (_flat || i == name.npos) {
-        _map[name] = vp;
+        _store(name, std::move(values));
         return;
     }
-    std::string prefix(name, 0, i);
-    std::string suffix(name, i + 1);
-    AnyMap::iterator j = _map.find(prefix);
-    if (j == _map.end()) {
-        auto pp = std::make_shared<PropertySet>();
-        pp->_findOrInsert(suffix, vp);
-        std::shared_ptr<std::vector<std::any>> temp(new std::vector<std::any>);
-        temp->push_back(pp);
-        _map[prefix] = temp;
+    std::string_view prefix = name.substr(0, i);
+    std::string_view suffix = name.substr(i + 1);
+    auto const j = _map->find(prefix);
+    if (j == _map->end()) {
+        auto pp = _makeEmpty(false);
+        pp->_findOrInsert(suffix, std::move(values));
+        _store(prefix, Values(pp, _resource()));
         return;
-    } else if (j->second->back().type() != typeid(std::shared_ptr<PropertySet>)) {
+    } else if (j->second.type() != Type::PropertySet) {
         throw LSST_EXCEPT(pex::exceptions::InvalidParameterError,
-                          prefix + " exists but does not contain PropertySets");
+                          std::string(prefix) + " exists but does not contain PropertySets");
     }
-    auto p = std::any_cast<std::shared_ptr<PropertySet>>(j->second->back());
+    auto p = j->second.back<std::shared_ptr<PropertySet>>();
     if (p.get() == 0) {
         throw LSST_EXCEPT(pex::exceptions::InvalidParameterError,
-                          prefix + " exists but contains a null PropertySet");
+                          std::string(prefix) + " exists but contains a null PropertySet");
     }
-    p->_findOrInsert(suffix, vp);
+    p->_findOrInsert(suffix, std::move(values));
 }
 
-void PropertySet::_cycleCheckPtrVec(
-    std::vector<std::shared_ptr<PropertySet>> const& v,
-    std::string const& name
-) {
-    for (auto const& i : v) {
-        _cycleCheckPtr(i, name);
+std::uint64_t PropertySet::_contribution(std::string_view key, Values const& values, std::size_t from) {
+    if (values.type() == Type::PropertySet) {
+        return 0;
+    }
+    // Each value is hashed with the key, the type and its index, and the
+    // hashes summed, so that properties can be added and removed in any order
+    std::uint64_t const seed = detail::fingerprintBytes(static_cast<std::uint64_t>(values.type()) + 1, key);
+    std::uint64_t result = 0;
+    values.visit([seed, from, &result](auto const* data, std::size_t size) {
+        for (std::size_t i = from; i < size; ++i) {
+            std::uint64_t const position = detail::fingerprintMix(seed + i * 0x9E3779B97F4A7C15ULL);
+            result += detail::fingerprintMix(_fingerprintValue(data[i]) ^ position);
+        }
+    });
+    return result;
+}
+
+bool PropertySet::_store(std::string_view key, Values values) {
+    values.rebind(_resource());
+    std::uint64_t const contribution = _contribution(key, values);
+    bool const nested = values.type() == Type::PropertySet;
+    AnyMap& map = _map.write();
+    auto const i = map.find(key);
+    bool const inserted = i == map.end();
+    if (inserted) {
+        map.emplace(key, std::move(values));
+    } else {
+        _fingerprint -= _contribution(key, i->second);
+        _nestedCount -= i->second.type() == Type::PropertySet;
+        i->second = std::move(values);
     }
+    _fingerprint += contribution;
+    _nestedCount += nested;
+    return inserted;
 }
 
-void PropertySet::_cycleCheckAnyVec(std::vector<std::any> const& v, std::string const& name) {
-    for (auto const& i : v) {
-        _cycleCheckPtr(std::any_cast<std::shared_ptr<PropertySet>>(i), name);
+void PropertySet::_rehash() {
+    _fingerprint = 0;
+    _nestedCount = 0;
+    for (auto const& elt : *_map) {
+        _fingerprint += _contribution(elt.first.view(), elt.second);
+        _nestedCount += elt.second.type() == Type::PropertySet;
     }
 }
 
-void PropertySet::_cycleCheckPtr(std::shared_ptr<PropertySet> const & v, std::string const& name) {
-    if (v.get() == this) {
-        throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, name + " would cause a cycle");
+std::shared_ptr<PropertySet> PropertySet::_makeEmpty(bool flat) const {
+    if (_resource()) {
+        return std::allocate_shared<PropertySet>(std::pmr::polymorphic_allocator<PropertySet>(_resource()),
+                                                 _resource(), flat);
     }
-    std::vector<std::string> sets = v->propertySetNames(false);
-    for (auto const& i : sets) {
-        if (v->getAsPropertySetPtr(i).get() == this) {
-            throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, name + " would cause a cycle");
+    return std::make_shared<PropertySet>(flat);
+}
+
+void PropertySet::_collect(std::string const& prefix,
+                           std::vector<std::pair<std::string, Values const*>>& entries) const {
+    for (auto const& elt : *_map) {
+        std::string name = prefix + elt.first.str();
+        if (!_flat && elt.second.type() == Type::PropertySet) {
+            auto p = elt.second.back<std::shared_ptr<PropertySet>>();
+            if (p.get() != 0) {
+                p->_collect(name + ".", entries);
+            }
         }
+        entries.emplace_back(std::move(name), &elt.second);
+    }
+}
+
+template <typename T>
+T PropertySet::_back(Values const& values, std::string_view name) {
+    if (values.type() != typeTagOfT<T>()) {
+        throw LSST_EXCEPT(pex::exceptions::TypeError, std::string(name));
+    }
+    return values.back<T>();
+}
+
+template <typename T>
+std::vector<T> PropertySet::_toVector(Values const& values, std::string_view name) {
+    if (values.type() != typeTagOfT<T>()) {
+        throw LSST_EXCEPT(pex::exceptions::TypeError, std::string(name));
+    }
+    return values.toVector<T>();
+}
+
+template <typename T>
+PropertySet::ArrayView<T> PropertySet::_view(Values const& values, std::string_view name) {
+    if (values.type() != typeTagOfT<T>()) {
+        throw LSST_EXCEPT(pex::exceptions::TypeError, std::string(name));
+    }
+    return values.template view<T>();
+}
+
+PropertySet::Values const& PropertySet::_at(std::string_view name) const {
+    auto const i = _find(name);
+    if (i == nullptr) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
+    }
+    return i->second;
+}
+
+std::type_info const& PropertySet::_typeOf(Values const& values) {
+    return dispatch(values.type(), [](auto t) -> std::type_info const& {
+        return typeid(typename decltype(t)::type);
+    });
+}
+
+bool PropertySet::_equal(Values const& a, Values const& b) {
+    if (a.type() != b.type() || a.size() != b.size()) {
+        return false;
+    }
+    return dispatch(a.type(), [&a, &b](auto t) {
+        typedef typename decltype(t)::type T;
+        ArrayView<T> const x = a.view<T>();
+        ArrayView<T> const y = b.view<T>();
+        if constexpr (!std::is_same<T, std::string>::value) {
+            if (x.data() == y.data()) {
+                return true;  // An array shared by copies
+            }
+        }
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            if constexpr (std::is_floating_point<T>::value) {
+                if (x[i] != y[i] && !(std::isnan(x[i]) && std::isnan(y[i]))) {
+                    return false;
+                }
+            } else if constexpr (std::is_same<T, std::shared_ptr<PropertySet>>::value) {
+                if (x[i] != y[i] && !(x[i] && y[i] && *x[i] == *y[i])) {
+                    return false;
+                }
+            } else if (!(x[i] == y[i])) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+bool PropertySet::_sameContents(PropertySet const& other) const {
+    if (&*_map == &*other._map) {
+        return true;  // Storage shared by deep copies
+    }
+    if (_map->size() != other._map->size()) {
+        return false;
+    }
+    for (auto const& elt : *_map) {
+        auto const i = other._map->find(elt.first.view());
+        if (i == other._map->end() || !_equal(elt.second, i->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PropertySet::Values PropertySet::_isolate(Values const& values, std::pmr::memory_resource* resource) {
+    if (values.type() != Type::PropertySet) {
+        Values copy(values);
+        copy.rebind(resource);
+        return copy;
+    }
+    std::vector<std::shared_ptr<PropertySet>> sets = values.toVector<std::shared_ptr<PropertySet>>();
+    for (auto& p : sets) {
+        if (p) {
+            p = p->deepCopy();
+        }
+    }
+    return Values(std::move(sets), resource);
+}
+
+// Walk everything reachable from v once, by pointer, looking for this set.
+// Sets holding no PropertySets end the walk without allocating.
+
+void PropertySet::_cycleCheckPtrVec(ArrayView<std::shared_ptr<PropertySet>> v, std::string_view name) {
+    std::vector<PropertySet const*> stack;
+    std::unordered_set<PropertySet const*> visited;
+    auto push = [&](std::shared_ptr<PropertySet> const& p) {
+        if (p.get() == this) {
+            throw LSST_EXCEPT(pex::exceptions::InvalidParameterError,
+                              std::string(name) + " would cause a cycle");
+        }
+        if (p && p->_nestedCount != 0 && visited.insert(p.get()).second) {
+            stack.push_back(p.get());
+        }
+    };
+    for (auto const& p : v) {
+        push(p);
+    }
+    while (!stack.empty()) {
+        PropertySet const* const p = stack.back();
+        stack.pop_back();
+        for (auto const& elt : *p->_map) {
+            if (elt.second.type() == Type::PropertySet) {
+                for (auto const& q : elt.second.view<std::shared_ptr<PropertySet>>()) {
+                    push(q);
+                }
+            }
+        }
+    }
+}
+
+void PropertySet::_cycleCheckPtr(std::shared_ptr<PropertySet> const& v, std::string_view name) {
+    _cycleCheckPtrVec(ArrayView<std::shared_ptr<PropertySet>>(&v, 1), name);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// EntryIterator
+///////////////////////////////////////////////////////////////////////////////
+
+// Only sets that hold PropertySets need the stack; nothing is allocated
+// until the first descent, and _path is reused thereafter.
+
+PropertySet::EntryIterator::EntryIterator(PropertySet const& set, bool topLevelOnly)
+        : _top{set._map->begin(), set._map->end(), 0},
+          _map(&*set._map),
+          _ordered(set._orderedNames()),
+          _recursive(!topLevelOnly && set._nestedCount != 0) {
+    if (_ordered) {
+        _next = _ordered->begin();
+    }
+}
+
+PropertySet::Entry PropertySet::EntryIterator::operator*() const noexcept {
+    if (_ordered) {
+        return Entry(*_next, _map->find(*_next)->second);
+    }
+    auto const& elt = *_top.current;
+    return Entry(_top.prefix == 0 ? elt.first.view() : std::string_view(_path), elt.second);
+}
+
+PropertySet::EntryIterator& PropertySet::EntryIterator::operator++() {
+    if (_ordered) {
+        ++_next;
+        return *this;
+    }
+    if (_recursive && _top.current->second.type() == Type::PropertySet) {
+        auto const& p = _top.current->second.view<std::shared_ptr<PropertySet>>().back();
+        if (p) {
+            // The contents of a set come right after the set itself
+            _path.resize(_top.prefix);
+            _path.append(_top.current->first.view());
+            _path.push_back('.');
+            _parents.push_back(_top);
+            _top = Frame{p->_map->begin(), p->_map->end(), _path.size()};
+            _settle();
+            return *this;
+        }
+    }
+    ++_top.current;
+    _settle();
+    return *this;
+}
+
+void PropertySet::EntryIterator::_settle() {
+    while (_top.current == _top.end && !_parents.empty()) {
+        _top = _parents.back();
+        _parents.pop_back();
+        ++_top.current;
+    }
+    if (_top.prefix != 0 && _top.current != _top.end) {
+        _path.resize(_top.prefix);
+        _path.append(_top.current->first.view());
     }
 }
 
 std::ostream &operator<<(std::ostream &os, PropertySet const &propertySet)
 {
-    os << propertySet.toString() << std::endl;
+    std::string out;
+    propertySet._write(out, false, "");
+    os.write(out.data(), out.size());
+    os << std::endl;
     return os;
 }
 
@@ -752,23 +1882,55 @@ std::ostream &operator<<(std::ostream &os, PropertySet const &propertySet)
     /// @cond
     // Explicit template instantiations are not well understood by doxygen.
 
-#define INSTANTIATE(t)                                                                       \
-    template std::type_info const& PropertySet::typeOfT<t>();                                \
-    template t PropertySet::get<t>(std::string const& name) const;                           \
-    template t PropertySet::get<t>(std::string const& name, t const& defaultValue) const;    \
-    template std::vector<t> PropertySet::getArray<t>(std::string const& name) const;         \
-    template void PropertySet::set<t>(std::string const& name, t const& value);              \
-    template void PropertySet::set<t>(std::string const& name, std::vector<t> const& value); \
-    template void PropertySet::add<t>(std::string const& name, t const& value);              \
-    template void PropertySet::add<t>(std::string const& name, std::vector<t> const& value);
-
-#define INSTANTIATE_PROPERTY_SET(t)                                                       \
-    template std::type_info const& PropertySet::typeOfT<t>();                             \
-    template t PropertySet::get<t>(std::string const& name) const;                        \
-    template t PropertySet::get<t>(std::string const& name, t const& defaultValue) const; \
-    template std::vector<t> PropertySet::getArray<t>(std::string const& name) const;      \
-    template void PropertySet::set<t>(std::string const& name, t const& value);           \
-    template void PropertySet::set<t>(std::string const& name, std::vector<t> const& value);
+#define INSTANTIATE(t)                                                                                      \
+    template std::type_info const& PropertySet::typeOfT<t>();                                               \
+    template PropertySet::Type PropertySet::typeTagOfT<t>();                                                \
+    template PropertySet::Item::Item(std::string name, t const& value, std::optional<std::string> comment); \
+    template PropertySet::Item::Item(std::string name, std::vector<t> const& value,                         \
+                                     std::optional<std::string> comment);                                   \
+    template t PropertySet::get<t>(std::string_view name) const;                                            \
+    template t PropertySet::get<t>(std::string_view name, t const& defaultValue) const;                     \
+    template std::vector<t> PropertySet::getArray<t>(std::string_view name) const;                          \
+    template std::optional<t> PropertySet::tryGet<t>(std::string_view name) const;                          \
+    template std::optional<std::vector<t>> PropertySet::tryGetArray<t>(std::string_view name) const;        \
+    template PropertySet::ArrayView<t> PropertySet::getArrayView<t>(std::string_view name) const;           \
+    template std::size_t PropertySet::getArrayInto<t>(std::string_view name, t* buffer,                     \
+                                                      std::size_t size) const;                              \
+    template t PropertySet::get<t>(PropertySet::Key<t> const& key) const;                                   \
+    template void PropertySet::set<t>(std::string const& name, t const& value);                             \
+    template void PropertySet::set<t>(std::string const& name, std::vector<t> const& value);                \
+    template void PropertySet::set<t>(PropertySet::Key<t> const& key, t const& value);                      \
+    template void PropertySet::add<t>(std::string const& name, t const& value);                             \
+    template void PropertySet::add<t>(std::string const& name, std::vector<t> const& value);                \
+    template void PropertySet::set<t>(std::string const& name, std::vector<t>&& value);                     \
+    template void PropertySet::add<t>(std::string const& name, std::vector<t>&& value);                     \
+    template t PropertySet::_back<t>(Values const& values, std::string_view name);                          \
+    template std::vector<t> PropertySet::_toVector<t>(Values const& values, std::string_view name);         \
+    template PropertySet::ArrayView<t> PropertySet::_view<t>(Values const& values, std::string_view name);
+
+#define INSTANTIATE_PROPERTY_SET(t)                                                                         \
+    template std::type_info const& PropertySet::typeOfT<t>();                                               \
+    template PropertySet::Type PropertySet::typeTagOfT<t>();                                                \
+    template PropertySet::Item::Item(std::string name, t const& value, std::optional<std::string> comment); \
+    template PropertySet::Item::Item(std::string name, std::vector<t> const& value,                         \
+                                     std::optional<std::string> comment);                                   \
+    template t PropertySet::get<t>(std::string_view name) const;                                            \
+    template t PropertySet::get<t>(std::string_view name, t const& defaultValue) const;                     \
+    template std::vector<t> PropertySet::getArray<t>(std::string_view name) const;                          \
+    template std::optional<t> PropertySet::tryGet<t>(std::string_view name) const;                          \
+    template std::optional<std::vector<t>> PropertySet::tryGetArray<t>(std::string_view name) const;        \
+    template PropertySet::ArrayView<t> PropertySet::getArrayView<t>(std::string_view name) const;           \
+    template std::size_t PropertySet::getArrayInto<t>(std::string_view name, t* buffer,                     \
+                                                      std::size_t size) const;                              \
+    template t PropertySet::get<t>(PropertySet::Key<t> const& key) const;                                   \
+    template void PropertySet::set<t>(std::string const& name, t const& value);                             \
+    template void PropertySet::set<t>(std::string const& name, std::vector<t> const& value);                \
+    template void PropertySet::set<t>(PropertySet::Key<t> const& key, t const& value);                      \
+    template void PropertySet::set<t>(std::string const& name, std::vector<t>&& value);                     \
+    template void PropertySet::add<t>(std::string const& name, std::vector<t>&& value);                     \
+    template t PropertySet::_back<t>(Values const& values, std::string_view name);                          \
+    template std::vector<t> PropertySet::_toVector<t>(Values const& values, std::string_view name);         \
+    template PropertySet::ArrayView<t> PropertySet::_view<t>(Values const& values, std::string_view name);
 
 INSTANTIATE(bool)
 INSTANTIATE(char)
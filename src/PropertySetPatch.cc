@@ -0,0 +1,558 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "lsst/daf/base/PropertySetPatch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include "lsst/pex/exceptions/Runtime.h"
+#include "lsst/daf/base/DateTime.h"
+#include "lsst/daf/base/PropertyList.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+namespace {
+
+/*
+ * A serialized patch is the magic bytes and the format version, then the
+ * edits and the order, all as counts, tags and values.  Counts and integers
+ * are little-endian base-128 varints, signed integers zigzag-encoded first;
+ * floating-point values are their IEEE bits, little-endian; strings are a
+ * count followed by the bytes.  Every value takes at least one byte, so no
+ * count can exceed the bytes that remain.
+ */
+char const MAGIC[] = {'P', 'S', 'P', 'T'};
+std::uint8_t const VERSION = 1;
+
+// Deepest nesting of PropertySets accepted when decoding
+int const MAX_DEPTH = 256;
+
+// Leading byte of a nested set: a PropertySet, flat or not, or a PropertyList
+enum SetKind : std::uint8_t { HIERARCHICAL = 0, FLAT = 1, LIST = 2 };
+
+typedef std::shared_ptr<PropertySet> PropertySetPtr;
+
+[[noreturn]] void malformed(std::string const& why) {
+    throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, "Malformed PropertySet patch: " + why);
+}
+
+void putVarint(std::string& out, std::uint64_t x) {
+    while (x >= 0x80) {
+        out.push_back(static_cast<char>((x & 0x7F) | 0x80));
+        x >>= 7;
+    }
+    out.push_back(static_cast<char>(x));
+}
+
+void putSigned(std::string& out, std::int64_t x) {
+    putVarint(out, (static_cast<std::uint64_t>(x) << 1) ^ static_cast<std::uint64_t>(x >> 63));
+}
+
+template <typename U>
+void putFixed(std::string& out, U x) {
+    for (std::size_t i = 0; i < sizeof(U); ++i) {
+        out.push_back(static_cast<char>(x & 0xFF));
+        x >>= 8;
+    }
+}
+
+void putString(std::string& out, std::string_view s) {
+    putVarint(out, s.size());
+    out.append(s);
+}
+
+// Encode one value of type T; v is a std::string_view for strings
+template <typename T, typename V>
+void putValue(std::string& out, V const& v) {
+    if constexpr (std::is_same<T, bool>::value) {
+        out.push_back(v ? 1 : 0);
+    } else if constexpr (sizeof(T) == 1 && std::is_integral<T>::value) {
+        out.push_back(static_cast<char>(v));
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        putSigned(out, v);
+    } else if constexpr (std::is_integral<T>::value) {
+        putVarint(out, v);
+    } else if constexpr (std::is_same<T, float>::value) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        putFixed(out, bits);
+    } else if constexpr (std::is_same<T, double>::value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        putFixed(out, bits);
+    } else if constexpr (std::is_same<T, std::nullptr_t>::value) {
+        out.push_back(0);
+    } else if constexpr (std::is_same<T, std::string>::value) {
+        putString(out, v);
+    } else {
+        static_assert(std::is_same<T, DateTime>::value, "Unsupported type");
+        putSigned(out, v.nsecs());
+    }
+}
+
+template <typename T>
+void putArray(std::string& out, PropertySet::ArrayView<T> const& values) {
+    putVarint(out, values.size());
+    for (auto const& value : values) {
+        putValue<T>(out, value);
+    }
+}
+
+std::uint8_t getByte(std::string_view& in) {
+    if (in.empty()) {
+        malformed("truncated");
+    }
+    auto const byte = static_cast<std::uint8_t>(in.front());
+    in.remove_prefix(1);
+    return byte;
+}
+
+std::uint64_t getVarint(std::string_view& in) {
+    std::uint64_t x = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        std::uint8_t const byte = getByte(in);
+        x |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return x;
+        }
+    }
+    malformed("integer too long");
+}
+
+std::int64_t getSigned(std::string_view& in) {
+    std::uint64_t const z = getVarint(in);
+    return static_cast<std::int64_t>((z >> 1) ^ (~(z & 1) + 1));
+}
+
+template <typename U>
+U getFixed(std::string_view& in) {
+    if (in.size() < sizeof(U)) {
+        malformed("truncated");
+    }
+    U x = 0;
+    for (std::size_t i = 0; i < sizeof(U); ++i) {
+        x |= static_cast<U>(static_cast<std::uint8_t>(in[i])) << (8 * i);
+    }
+    in.remove_prefix(sizeof(U));
+    return x;
+}
+
+// A count of items that each take at least one byte of the input
+std::size_t getCount(std::string_view& in) {
+    std::uint64_t const n = getVarint(in);
+    if (n > in.size()) {
+        malformed("count exceeds the data");
+    }
+    return n;
+}
+
+std::string_view getString(std::string_view& in) {
+    std::size_t const n = getCount(in);
+    std::string_view const s = in.substr(0, n);
+    in.remove_prefix(n);
+    return s;
+}
+
+template <typename T>
+T getValue(std::string_view& in) {
+    if constexpr (std::is_same<T, bool>::value) {
+        return getByte(in) != 0;
+    } else if constexpr (sizeof(T) == 1 && std::is_integral<T>::value) {
+        return static_cast<T>(getByte(in));
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        std::int64_t const x = getSigned(in);
+        if (x < std::numeric_limits<T>::min() || x > std::numeric_limits<T>::max()) {
+            malformed("integer out of range");
+        }
+        return static_cast<T>(x);
+    } else if constexpr (std::is_integral<T>::value) {
+        std::uint64_t const x = getVarint(in);
+        if (x > std::numeric_limits<T>::max()) {
+            malformed("integer out of range");
+        }
+        return static_cast<T>(x);
+    } else if constexpr (std::is_same<T, float>::value) {
+        std::uint32_t const bits = getFixed<std::uint32_t>(in);
+        float x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    } else if constexpr (std::is_same<T, double>::value) {
+        std::uint64_t const bits = getFixed<std::uint64_t>(in);
+        double x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    } else if constexpr (std::is_same<T, std::nullptr_t>::value) {
+        getByte(in);
+        return nullptr;
+    } else if constexpr (std::is_same<T, std::string>::value) {
+        return std::string(getString(in));
+    } else {
+        static_assert(std::is_same<T, DateTime>::value, "Unsupported type");
+        return DateTime(static_cast<long long>(getSigned(in)), DateTime::TAI);
+    }
+}
+
+template <typename T>
+std::vector<T> getArray(std::string_view& in) {
+    std::size_t const n = getCount(in);
+    if (n == 0) {
+        malformed("no values");
+    }
+    std::vector<T> values;
+    values.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        values.push_back(getValue<T>(in));
+    }
+    return values;
+}
+
+// The nested PropertySet held by values if it holds exactly one and it is a
+// plain PropertySet, else null.  Edits to the names within a PropertyList
+// would bypass its order and comments, so such a set is replaced whole.
+PropertySet const* plainChild(PropertySet::ArrayView<PropertySetPtr> const& sets) {
+    if (sets.size() != 1 || !sets.front() || typeid(*sets.front()) != typeid(PropertySet)) {
+        return nullptr;
+    }
+    return sets.front().get();
+}
+
+}  // namespace
+
+PropertySetPatch::PropertySetPatch() : _values(std::make_shared<PropertySet>(true)) {}
+
+PropertySetPatch::PropertySetPatch(PropertySetPatch const&) = default;
+PropertySetPatch::PropertySetPatch(PropertySetPatch&&) noexcept = default;
+PropertySetPatch& PropertySetPatch::operator=(PropertySetPatch const&) = default;
+PropertySetPatch& PropertySetPatch::operator=(PropertySetPatch&&) noexcept = default;
+PropertySetPatch::~PropertySetPatch() noexcept = default;
+
+PropertySetPatch PropertySetPatch::diff(PropertySet const& from, PropertySet const& to) {
+    PropertySetPatch patch;
+    patch._diff("", from, to);
+    // _diff puts the removals from a nested set where it meets the set, after
+    // the additions and changes that come before it; bring them all forward
+    std::stable_partition(patch._edits.begin(), patch._edits.end(),
+                          [](Edit const& edit) { return edit.kind == Edit::Kind::Remove; });
+    auto const* fromList = dynamic_cast<PropertyList const*>(&from);
+    auto const* toList = dynamic_cast<PropertyList const*>(&to);
+    if (fromList && toList) {
+        // The order apply gives: surviving names in their old order, then the new ones
+        std::vector<std::string_view> order;
+        for (auto const& name : *fromList) {
+            if (toList->exists(name)) {
+                order.push_back(name);
+            }
+        }
+        for (auto const& edit : patch._edits) {
+            if (edit.kind == Edit::Kind::Add) {
+                order.push_back(edit.name);
+            }
+        }
+        if (!std::equal(order.begin(), order.end(), toList->begin(), toList->end())) {
+            patch._order = toList->getOrderedNames();
+        }
+    }
+    return patch;
+}
+
+std::string PropertySetPatch::serialize() const {
+    std::string out(MAGIC, sizeof(MAGIC));
+    out.push_back(static_cast<char>(VERSION));
+    putVarint(out, _edits.size());
+    for (auto const& edit : _edits) {
+        out.push_back(static_cast<char>(edit.kind));
+        putString(out, edit.name);
+        if (edit.kind != Edit::Kind::Remove) {
+            putString(out, edit.comment);
+            _writeValues(out, _values->_map->find(edit.name)->second);
+        }
+    }
+    putVarint(out, _order.size());
+    for (auto const& name : _order) {
+        putString(out, name);
+    }
+    return out;
+}
+
+PropertySetPatch PropertySetPatch::deserialize(std::string_view bytes) {
+    if (bytes.substr(0, sizeof(MAGIC)) != std::string_view(MAGIC, sizeof(MAGIC))) {
+        malformed("not a serialized patch");
+    }
+    bytes.remove_prefix(sizeof(MAGIC));
+    if (getByte(bytes) != VERSION) {
+        malformed("unsupported version");
+    }
+    PropertySetPatch patch;
+    std::size_t const nEdits = getCount(bytes);
+    for (std::size_t i = 0; i < nEdits; ++i) {
+        std::uint8_t const kind = getByte(bytes);
+        if (kind > static_cast<std::uint8_t>(Edit::Kind::Change)) {
+            malformed("unknown edit");
+        }
+        Edit edit{static_cast<Edit::Kind>(kind), std::string(getString(bytes)), std::string()};
+        if (edit.kind != Edit::Kind::Remove) {
+            edit.comment = getString(bytes);
+            Values values = _readValues(bytes, 0);
+            if (!patch._values->_setTopLevel(edit.name, std::move(values))) {
+                malformed("name " + edit.name + " edited twice");
+            }
+        }
+        patch._edits.push_back(std::move(edit));
+    }
+    std::size_t const nOrder = getCount(bytes);
+    for (std::size_t i = 0; i < nOrder; ++i) {
+        patch._order.emplace_back(getString(bytes));
+    }
+    if (!bytes.empty()) {
+        malformed("unexpected data at the end");
+    }
+    return patch;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private member functions
+///////////////////////////////////////////////////////////////////////////////
+
+void PropertySetPatch::_diff(std::string const& prefix, PropertySet const& from, PropertySet const& to) {
+    auto const* fromList = dynamic_cast<PropertyList const*>(&from);
+    auto const* toList = dynamic_cast<PropertyList const*>(&to);
+    for (auto const& elt : *from._map) {
+        if (to._map->find(elt.first.view()) == to._map->end()) {
+            _edits.push_back(Edit{Edit::Kind::Remove, prefix + elt.first.str(), std::string()});
+        }
+    }
+    auto compare = [&](std::string const& key, Values const& values) {
+        std::string const comment = toList ? toList->getComment(key) : std::string();
+        auto const i = from._map->find(key);
+        if (i == from._map->end()) {
+            _addEdit(Edit::Kind::Add, prefix + key, values, comment);
+            return;
+        }
+        if (i->second.type() == PropertySet::Type::PropertySet &&
+            values.type() == PropertySet::Type::PropertySet) {
+            PropertySet const* fromChild = plainChild(PropertySet::_view<PropertySetPtr>(i->second, key));
+            PropertySet const* toChild = plainChild(PropertySet::_view<PropertySetPtr>(values, key));
+            if (fromChild && toChild) {
+                _diff(prefix + key + ".", *fromChild, *toChild);
+                return;
+            }
+        }
+        bool const commentChanged = fromList && toList && fromList->getComment(key) != comment;
+        if (commentChanged || !PropertySet::_equal(i->second, values)) {
+            _addEdit(Edit::Kind::Change, prefix + key, values, comment);
+        }
+    };
+    if (toList) {
+        // Visit the names in order, so that apply adds them in order
+        for (auto const& name : *toList) {
+            compare(name, to._map->find(name)->second);
+        }
+    } else {
+        for (auto const& elt : *to._map) {
+            compare(elt.first.str(), elt.second);
+        }
+    }
+}
+
+void PropertySetPatch::_addEdit(Edit::Kind kind, std::string name, Values const& values,
+                                std::string comment) {
+    _values->_setTopLevel(name, PropertySet::_isolate(values, nullptr));
+    _edits.push_back(Edit{kind, std::move(name), std::move(comment)});
+}
+
+void PropertySetPatch::_writeValues(std::string& out, Values const& values) {
+    typedef PropertySet::Type Type;
+    out.push_back(static_cast<char>(values.type()));
+    switch (values.type()) {
+        case Type::Bool:
+            return putArray(out, PropertySet::_view<bool>(values, ""));
+        case Type::Char:
+            return putArray(out, PropertySet::_view<char>(values, ""));
+        case Type::SignedChar:
+            return putArray(out, PropertySet::_view<signed char>(values, ""));
+        case Type::UnsignedChar:
+            return putArray(out, PropertySet::_view<unsigned char>(values, ""));
+        case Type::Short:
+            return putArray(out, PropertySet::_view<short>(values, ""));
+        case Type::UnsignedShort:
+            return putArray(out, PropertySet::_view<unsigned short>(values, ""));
+        case Type::Int:
+            return putArray(out, PropertySet::_view<int>(values, ""));
+        case Type::UnsignedInt:
+            return putArray(out, PropertySet::_view<unsigned int>(values, ""));
+        case Type::Long:
+            return putArray(out, PropertySet::_view<long>(values, ""));
+        case Type::UnsignedLong:
+            return putArray(out, PropertySet::_view<unsigned long>(values, ""));
+        case Type::LongLong:
+            return putArray(out, PropertySet::_view<long long>(values, ""));
+        case Type::UnsignedLongLong:
+            return putArray(out, PropertySet::_view<unsigned long long>(values, ""));
+        case Type::Float:
+            return putArray(out, PropertySet::_view<float>(values, ""));
+        case Type::Double:
+            return putArray(out, PropertySet::_view<double>(values, ""));
+        case Type::Undef:
+            return putArray(out, PropertySet::_view<std::nullptr_t>(values, ""));
+        case Type::String:
+            return putArray(out, PropertySet::_view<std::string>(values, ""));
+        case Type::PropertySet: {
+            auto const sets = PropertySet::_view<PropertySetPtr>(values, "");
+            putVarint(out, sets.size());
+            for (auto const& p : sets) {
+                out.push_back(p ? 1 : 0);
+                if (p) {
+                    _writeSet(out, *p);
+                }
+            }
+            return;
+        }
+        case Type::Persistable:
+            throw LSST_EXCEPT(pex::exceptions::TypeError, "Persistable values cannot be serialized");
+        case Type::DateTime:
+            return putArray(out, PropertySet::_view<DateTime>(values, ""));
+    }
+}
+
+void PropertySetPatch::_writeSet(std::string& out, PropertySet const& set) {
+    // A PropertyList is written in its order, each name with its comment
+    auto const* list = dynamic_cast<PropertyList const*>(&set);
+    if (list) {
+        out.push_back(LIST);
+        putVarint(out, set._map->size());
+        for (auto const& name : *list) {
+            putString(out, name);
+            putString(out, list->getComment(name));
+            _writeValues(out, set._map->find(name)->second);
+        }
+        return;
+    }
+    out.push_back(set._flat ? FLAT : HIERARCHICAL);
+    putVarint(out, set._map->size());
+    for (auto const& elt : *set._map) {
+        putString(out, elt.first.view());
+        _writeValues(out, elt.second);
+    }
+}
+
+PropertySetPatch::Values PropertySetPatch::_readValues(std::string_view& in, int depth) {
+    typedef PropertySet::Type Type;
+    // Item builds cells from vectors of any type
+    auto cell = [](auto const& values) {
+        PropertySet::Item item(std::string(), values);
+        return std::move(item._values);
+    };
+    switch (static_cast<Type>(getByte(in))) {
+        case Type::Bool:
+            return cell(getArray<bool>(in));
+        case Type::Char:
+            return cell(getArray<char>(in));
+        case Type::SignedChar:
+            return cell(getArray<signed char>(in));
+        case Type::UnsignedChar:
+            return cell(getArray<unsigned char>(in));
+        case Type::Short:
+            return cell(getArray<short>(in));
+        case Type::UnsignedShort:
+            return cell(getArray<unsigned short>(in));
+        case Type::Int:
+            return cell(getArray<int>(in));
+        case Type::UnsignedInt:
+            return cell(getArray<unsigned int>(in));
+        case Type::Long:
+            return cell(getArray<long>(in));
+        case Type::UnsignedLong:
+            return cell(getArray<unsigned long>(in));
+        case Type::LongLong:
+            return cell(getArray<long long>(in));
+        case Type::UnsignedLongLong:
+            return cell(getArray<unsigned long long>(in));
+        case Type::Float:
+            return cell(getArray<float>(in));
+        case Type::Double:
+            return cell(getArray<double>(in));
+        case Type::Undef:
+            return cell(getArray<std::nullptr_t>(in));
+        case Type::String:
+            return cell(getArray<std::string>(in));
+        case Type::PropertySet: {
+            std::size_t const n = getCount(in);
+            if (n == 0) {
+                malformed("no values");
+            }
+            std::vector<PropertySetPtr> sets;
+            for (std::size_t i = 0; i < n; ++i) {
+                sets.push_back(getByte(in) ? _readSet(in, depth + 1) : PropertySetPtr());
+            }
+            return cell(sets);
+        }
+        case Type::DateTime:
+            return cell(getArray<DateTime>(in));
+        default:
+            malformed("unknown value type");
+    }
+}
+
+std::shared_ptr<PropertySet> PropertySetPatch::_readSet(std::string_view& in, int depth) {
+    if (depth > MAX_DEPTH) {
+        malformed("PropertySets nested too deeply");
+    }
+    std::uint8_t const kind = getByte(in);
+    if (kind > LIST) {
+        malformed("unknown kind of PropertySet");
+    }
+    bool const flat = kind != HIERARCHICAL;
+    std::shared_ptr<PropertyList> list = kind == LIST ? std::make_shared<PropertyList>() : nullptr;
+    std::shared_ptr<PropertySet> set = list ? list : std::make_shared<PropertySet>(flat);
+    std::size_t const n = getCount(in);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::string name(getString(in));
+        if (name.empty() || (!flat && name.find('.') != std::string::npos)) {
+            malformed("invalid name " + name);
+        }
+        std::string comment = list ? std::string(getString(in)) : std::string();
+        Values values = _readValues(in, depth);
+        if (list && values.type() == PropertySet::Type::PropertySet) {
+            malformed("PropertyList holding a PropertySet");
+        }
+        if (!set->_setTopLevel(name, std::move(values))) {
+            malformed("repeated name");
+        }
+        if (list) {
+            list->_comments.write().try_emplace(name, std::move(comment));
+            list->_order.write().push_back(std::move(name));
+        }
+    }
+    return set;
+}
+
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
@@ -0,0 +1,308 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "lsst/daf/base/PropertySetSnapshot.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "lsst/pex/exceptions/Runtime.h"
+#include "lsst/daf/base/DateTime.h"
+#include "lsst/daf/base/PropertyList.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+
+namespace {
+
+typedef std::shared_ptr<PropertySet> PropertySetPtr;
+
+}  // namespace
+
+PropertySetSnapshot::PropertySetSnapshot(PropertySet const& root)
+        : _root{root._map, root._flat, root._fingerprint, root._nestedCount}, _isList(false) {
+    if (auto const* list = dynamic_cast<PropertyList const*>(&root)) {
+        _isList = true;
+        _comments = list->_comments;
+        _order = list->_order;
+    }
+    for (auto const& elt : *_root.map) {
+        if (elt.second.type() == PropertySet::Type::PropertySet) {
+            for (auto const& p : PropertySet::_view<PropertySetPtr>(elt.second, elt.first.view())) {
+                if (p) {
+                    _share(*p);
+                }
+            }
+        }
+    }
+}
+
+PropertySetSnapshot::~PropertySetSnapshot() noexcept = default;
+
+std::shared_ptr<PropertySet> PropertySetSnapshot::thaw() const {
+    if (!_isList) {
+        return _thaw(_root);
+    }
+    auto result = std::make_shared<PropertyList>(_root.map.getResource());
+    result->_map = _root.map;
+    result->_fingerprint = _root.fingerprint;
+    result->_nestedCount = _root.nestedCount;
+    result->_comments = _comments;
+    result->_order = _order;
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Accessors
+///////////////////////////////////////////////////////////////////////////////
+
+std::size_t PropertySetSnapshot::nameCount(bool topLevelOnly) const {
+    if (topLevelOnly) {
+        return _root.map->size();
+    }
+    return _nameCount(_root);
+}
+
+std::vector<std::string> PropertySetSnapshot::names(bool topLevelOnly) const {
+    std::vector<std::string> result;
+    _names(_root, "", topLevelOnly, result);
+    return result;
+}
+
+bool PropertySetSnapshot::isArray(std::string_view name) const {
+    Values const* values = _lookup(name);
+    return values && values->size() > 1U;
+}
+
+bool PropertySetSnapshot::isPropertySetPtr(std::string_view name) const {
+    Values const* values = _lookup(name);
+    return values && values->type() == PropertySet::Type::PropertySet;
+}
+
+std::size_t PropertySetSnapshot::valueCount(std::string_view name) const {
+    Values const* values = _lookup(name);
+    return values ? values->size() : 0;
+}
+
+std::type_info const& PropertySetSnapshot::typeOf(std::string_view name) const {
+    return PropertySet::_typeOf(_at(name));
+}
+
+template <typename T>
+T PropertySetSnapshot::get(std::string_view name) const {
+    Values const& values = _at(name);
+    if constexpr (std::is_same<T, PropertySetPtr>::value) {
+        PropertySet const* child = PropertySet::_view<T>(values, name).back().get();
+        return child ? _thaw(_node(child)) : nullptr;
+    } else {
+        return PropertySet::_back<T>(values, name);
+    }
+}
+
+template <typename T>
+T PropertySetSnapshot::get(std::string_view name, T const& defaultValue) const {
+    if (!exists(name)) {
+        return defaultValue;
+    }
+    return get<T>(name);
+}
+
+template <typename T>
+std::vector<T> PropertySetSnapshot::getArray(std::string_view name) const {
+    Values const& values = _at(name);
+    if constexpr (std::is_same<T, PropertySetPtr>::value) {
+        std::vector<T> result;
+        for (auto const& p : PropertySet::_view<T>(values, name)) {
+            result.push_back(p ? _thaw(_node(p.get())) : nullptr);
+        }
+        return result;
+    } else {
+        return PropertySet::_toVector<T>(values, name);
+    }
+}
+
+std::vector<std::string> PropertySetSnapshot::getOrderedNames() const {
+    if (!_isList) {
+        throw LSST_EXCEPT(pex::exceptions::LogicError, "Snapshot was not taken of a PropertyList");
+    }
+    return std::vector<std::string>(_order->begin(), _order->end());
+}
+
+std::string const& PropertySetSnapshot::getComment(std::string const& name) const {
+    if (!_isList) {
+        throw LSST_EXCEPT(pex::exceptions::LogicError, "Snapshot was not taken of a PropertyList");
+    }
+    auto const i = _comments->find(name);
+    if (i == _comments->end()) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, name + " not found");
+    }
+    return i->second;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private member functions
+///////////////////////////////////////////////////////////////////////////////
+
+void PropertySetSnapshot::_share(PropertySet const& set) {
+    if (!_nodes.emplace(&set, Node{set._map, set._flat, set._fingerprint, set._nestedCount}).second) {
+        return;  // Reachable by more than one path
+    }
+    for (auto const& elt : *set._map) {
+        if (elt.second.type() == PropertySet::Type::PropertySet) {
+            for (auto const& p : PropertySet::_view<PropertySetPtr>(elt.second, elt.first.view())) {
+                if (p) {
+                    _share(*p);
+                }
+            }
+        }
+    }
+}
+
+PropertySetSnapshot::Node const& PropertySetSnapshot::_node(PropertySet const* set) const {
+    return _nodes.find(set)->second;
+}
+
+PropertySetSnapshot::Values const* PropertySetSnapshot::_lookup(std::string_view name) const {
+    Node const* node = &_root;
+    for (;;) {
+        std::string_view::size_type const i = node->flat ? name.npos : name.find('.');
+        if (i == name.npos) {
+            auto const j = node->map->find(name);
+            return j == node->map->end() ? nullptr : &j->second;
+        }
+        auto const j = node->map->find(name.substr(0, i));
+        if (j == node->map->end() || j->second.type() != PropertySet::Type::PropertySet) {
+            return nullptr;
+        }
+        PropertySet const* child = _child(j->second);
+        if (!child) {
+            return nullptr;
+        }
+        node = &_node(child);
+        name = name.substr(i + 1);
+    }
+}
+
+PropertySetSnapshot::Values const& PropertySetSnapshot::_at(std::string_view name) const {
+    Values const* values = _lookup(name);
+    if (!values) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError, std::string(name) + " not found");
+    }
+    return *values;
+}
+
+void PropertySetSnapshot::_names(Node const& node, std::string const& prefix, bool topLevelOnly,
+                                 std::vector<std::string>& names) const {
+    for (auto const& elt : *node.map) {
+        std::string name = prefix + elt.first.str();
+        if (!topLevelOnly && elt.second.type() == PropertySet::Type::PropertySet) {
+            PropertySet const* child = _child(elt.second);
+            if (child) {
+                _names(_node(child), name + ".", false, names);
+            }
+        }
+        names.push_back(std::move(name));
+    }
+}
+
+std::size_t PropertySetSnapshot::_nameCount(Node const& node) const {
+    std::size_t n = node.map->size();
+    if (node.nestedCount == 0) {
+        return n;
+    }
+    for (auto const& elt : *node.map) {
+        if (elt.second.type() == PropertySet::Type::PropertySet) {
+            PropertySet const* child = _child(elt.second);
+            if (child) {
+                n += _nameCount(_node(child));
+            }
+        }
+    }
+    return n;
+}
+
+std::shared_ptr<PropertySet> PropertySetSnapshot::_thaw(Node const& node) const {
+    auto result = std::make_shared<PropertySet>(node.map.getResource(), node.flat);
+    bool const hasSets = std::any_of(node.map->begin(), node.map->end(), [](auto const& elt) {
+        return elt.second.type() == PropertySet::Type::PropertySet;
+    });
+    if (!hasSets) {
+        result->_map = node.map;
+        result->_fingerprint = node.fingerprint;
+        return result;
+    }
+    for (auto const& elt : *node.map) {
+        if (elt.second.type() == PropertySet::Type::PropertySet) {
+            for (auto const& p : PropertySet::_view<PropertySetPtr>(elt.second, elt.first.view())) {
+                result->add(elt.first.str(), p ? _thaw(_node(p.get())) : PropertySetPtr());
+            }
+        } else {
+            result->_map.write().emplace(elt.first, elt.second);
+        }
+    }
+    result->_fingerprint = node.fingerprint;  // The adds above counted the nested sets
+    return result;
+}
+
+PropertySet const* PropertySetSnapshot::_child(Values const& values) {
+    return PropertySet::_view<PropertySetPtr>(values, "").back().get();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Explicit template instantiations
+///////////////////////////////////////////////////////////////////////////////
+
+/// @cond
+// Explicit template instantiations are not well understood by doxygen.
+
+#define INSTANTIATE(t)                                                                          \
+    template t PropertySetSnapshot::get<t>(std::string_view name) const;                        \
+    template t PropertySetSnapshot::get<t>(std::string_view name, t const& defaultValue) const; \
+    template std::vector<t> PropertySetSnapshot::getArray<t>(std::string_view name) const;
+
+INSTANTIATE(bool)
+INSTANTIATE(char)
+INSTANTIATE(signed char)
+INSTANTIATE(unsigned char)
+INSTANTIATE(short)
+INSTANTIATE(unsigned short)
+INSTANTIATE(int)
+INSTANTIATE(unsigned int)
+INSTANTIATE(long)
+INSTANTIATE(unsigned long)
+INSTANTIATE(long long)
+INSTANTIATE(unsigned long long)
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(std::nullptr_t)
+INSTANTIATE(std::string)
+INSTANTIATE(std::shared_ptr<PropertySet>)
+INSTANTIATE(Persistable::Ptr)
+INSTANTIATE(DateTime)
+
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
+
+/// @endcond
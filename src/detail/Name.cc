@@ -0,0 +1,202 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "lsst/daf/base/detail/Name.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "lsst/pex/exceptions.h"
+
+namespace lsst {
+namespace daf {
+namespace base {
+namespace detail {
+
+namespace {
+
+static_assert(sizeof(Name) == 24, "Name should fit in 24 bytes");
+
+std::atomic<bool> interning(false);
+
+/*
+ * The process-wide intern table.  Atoms are allocated once and never freed,
+ * so the characters of an interned name stay valid for the life of the process.
+ */
+class AtomTable {
+public:
+    /// Find or add the atom for a name; return a pointer to its characters
+    char const* intern(std::string_view name) {
+        std::size_t const hash = std::hash<std::string_view>()(name);
+        {
+            std::shared_lock<std::shared_mutex> lock(_mutex);
+            auto const i = _atoms.find(name);
+            if (i != _atoms.end()) {
+                return i->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        auto const i = _atoms.find(name);
+        if (i != _atoms.end()) {
+            return i->second;
+        }
+        if (_atoms.size() >= Name::NO_ATOM) {
+            throw LSST_EXCEPT(pex::exceptions::LengthError, "Too many interned names");
+        }
+        void* p = ::operator new(sizeof(Name::AtomHeader) + name.size());
+        auto* header = new (p) Name::AtomHeader{hash, static_cast<std::uint32_t>(_atoms.size())};
+        char* chars = reinterpret_cast<char*>(header + 1);
+        std::memcpy(chars, name.data(), name.size());
+        _atoms.emplace(std::string_view(chars, name.size()), chars);
+        return chars;
+    }
+
+    std::size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        return _atoms.size();
+    }
+
+private:
+    mutable std::shared_mutex _mutex;
+    // Keys are views into the atoms themselves
+    std::unordered_map<std::string_view, char const*> _atoms;
+};
+
+// The resource that owned storage for a name was allocated from
+std::pmr::memory_resource* heapResource(char const* chars) noexcept {
+    std::pmr::memory_resource* resource;
+    std::memcpy(&resource, chars - sizeof(resource), sizeof(resource));
+    return resource;
+}
+
+AtomTable& atomTable() {
+    // Never destroyed, so interned names stay valid during static destruction
+    static AtomTable* table = new AtomTable();
+    return *table;
+}
+
+}  // namespace
+
+Name::Name(std::string_view name, std::pmr::memory_resource* resource) {
+    if (interning.load(std::memory_order_relaxed)) {
+        _chars = atomTable().intern(name);
+        _size = name.size();
+        _kind = INTERNED;
+    } else {
+        _assign(name, resource);
+    }
+}
+
+Name Name::intern(std::string_view name) {
+    Name result;
+    result._chars = atomTable().intern(name);
+    result._size = name.size();
+    result._kind = INTERNED;
+    return result;
+}
+
+Name::Name(Name const& other) {
+    if (other._kind == HEAP) {
+        _assign(other.view(), heapResource(other._chars));
+    } else {
+        std::memcpy(static_cast<void*>(this), &other, sizeof(Name));
+    }
+}
+
+Name::Name(Name const& other, std::pmr::memory_resource* resource) {
+    if (other._kind == HEAP) {
+        _assign(other.view(), resource);
+    } else {
+        std::memcpy(static_cast<void*>(this), &other, sizeof(Name));
+    }
+}
+
+Name::Name(Name&& other) noexcept {
+    std::memcpy(static_cast<void*>(this), &other, sizeof(Name));
+    other._size = 0;
+    other._kind = INLINE;
+}
+
+Name& Name::operator=(Name const& other) {
+    if (this != &other) {
+        Name copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+Name& Name::operator=(Name&& other) noexcept {
+    if (this != &other) {
+        _release();
+        std::memcpy(static_cast<void*>(this), &other, sizeof(Name));
+        other._size = 0;
+        other._kind = INLINE;
+    }
+    return *this;
+}
+
+Name::~Name() noexcept { _release(); }
+
+void Name::_assign(std::string_view name, std::pmr::memory_resource* resource) {
+    _size = name.size();
+    if (name.size() <= INLINE_SIZE) {
+        std::memcpy(_inline, name.data(), name.size());
+        _kind = INLINE;
+    } else {
+        std::size_t const bytes = sizeof(resource) + name.size();
+        void* p = resource ? resource->allocate(bytes, alignof(std::pmr::memory_resource*))
+                           : ::operator new(bytes);
+        *static_cast<std::pmr::memory_resource**>(p) = resource;
+        char* chars = static_cast<char*>(p) + sizeof(resource);
+        std::memcpy(chars, name.data(), name.size());
+        _chars = chars;
+        _kind = HEAP;
+    }
+}
+
+void Name::_release() noexcept {
+    if (_kind == HEAP) {
+        std::pmr::memory_resource* resource = heapResource(_chars);
+        void* p = const_cast<char*>(_chars) - sizeof(resource);
+        if (resource) {
+            resource->deallocate(p, sizeof(resource) + _size, alignof(std::pmr::memory_resource*));
+        } else {
+            ::operator delete(p);
+        }
+    }
+}
+
+void Name::setInterning(bool enable) noexcept { interning.store(enable, std::memory_order_relaxed); }
+
+bool Name::isInterning() noexcept { return interning.load(std::memory_order_relaxed); }
+
+std::size_t Name::internedCount() { return atomTable().size(); }
+
+}  // namespace detail
+}  // namespace base
+}  // namespace daf
+}  // namespace lsst
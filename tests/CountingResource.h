@@ -0,0 +1,70 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_DAF_BASE_TESTS_COUNTINGRESOURCE_H
+#define LSST_DAF_BASE_TESTS_COUNTINGRESOURCE_H
+
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+
+namespace {
+
+// Counts the bytes outstanding from a resource, checking that each
+// deallocation matches an allocation
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t allocations = 0;
+    std::size_t outstanding = 0;
+    std::size_t mismatches = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        _sizes[p] = bytes;
+        ++allocations;
+        outstanding += bytes;
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        auto const i = _sizes.find(p);
+        if (i == _sizes.end() || i->second != bytes) {
+            ++mismatches;
+        } else {
+            _sizes.erase(i);
+            outstanding -= bytes;
+        }
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::map<void*, std::size_t> _sizes;
+};
+
+}  // namespace
+
+#endif  // LSST_DAF_BASE_TESTS_COUNTINGRESOURCE_H
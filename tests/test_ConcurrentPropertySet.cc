@@ -0,0 +1,138 @@
+/*
+ * LSST Data Management System
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "lsst/daf/base/ConcurrentPropertySet.h"
+
+#define BOOST_TEST_MODULE ConcurrentPropertySet
+#define BOOST_TEST_DYN_LINK
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-variable"
+#include "boost/test/unit_test.hpp"
+#pragma clang diagnostic pop
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lsst/pex/exceptions/Runtime.h"
+
+namespace dafBase = lsst::daf::base;
+namespace pexExcept = lsst::pex::exceptions;
+
+BOOST_AUTO_TEST_SUITE(ConcurrentPropertySetSuite)
+
+BOOST_AUTO_TEST_CASE(accessors) {
+    dafBase::ConcurrentPropertySet cps(4);
+    BOOST_CHECK_EQUAL(cps.getShardCount(), 4U);
+    BOOST_CHECK_THROW(dafBase::ConcurrentPropertySet(0), pexExcept::InvalidParameterError);
+
+    cps.set("int", 42);
+    cps.set("string", "foo");
+    cps.set("a.b.c", 1.5);
+    cps.add("a.b.c", 2.5);
+    cps.add("ints", std::vector<int>{1, 2, 3});
+    BOOST_CHECK_EQUAL(cps.get<int>("int"), 42);
+    BOOST_CHECK_EQUAL(cps.get<std::string>("string"), "foo");
+    BOOST_CHECK_EQUAL(cps.get<double>("a.b.c"), 2.5);
+    BOOST_CHECK_EQUAL(cps.getArray<double>("a.b.c").size(), 2U);
+    BOOST_CHECK_EQUAL(cps.getArray<int>("ints")[2], 3);
+    BOOST_CHECK_EQUAL(cps.get<int>("missing", 7), 7);
+    BOOST_CHECK(cps.exists("a.b"));
+    BOOST_CHECK(!cps.exists("a.x"));
+    BOOST_CHECK_THROW(cps.get<int>("missing"), pexExcept::NotFoundError);
+    BOOST_CHECK_THROW(cps.get<int>("string"), pexExcept::TypeError);
+    BOOST_CHECK_THROW(cps.add("int", 1.0), pexExcept::TypeError);
+    BOOST_CHECK_THROW(cps.set("int.x", 1), pexExcept::InvalidParameterError);
+
+    std::vector<std::string> names = cps.names();
+    std::sort(names.begin(), names.end());
+    BOOST_CHECK(names == (std::vector<std::string>{"a", "int", "ints", "string"}));
+    BOOST_CHECK_EQUAL(cps.names(false).size(), 6U);
+
+    cps.remove("a.b.c");
+    BOOST_CHECK(!cps.exists("a.b.c"));
+    BOOST_CHECK(cps.exists("a.b"));
+
+    auto snapshot = cps.deepCopy();
+    BOOST_CHECK_EQUAL(snapshot->get<int>("int"), 42);
+    BOOST_CHECK(snapshot->exists("a.b"));
+    BOOST_CHECK_EQUAL(snapshot->nameCount(), 4U);
+    BOOST_CHECK_EQUAL(snapshot->names(false).size(), 5U);
+    cps.set("int", 0);
+    BOOST_CHECK_EQUAL(snapshot->get<int>("int"), 42);
+
+    // The shards are merged into one set like any other
+    dafBase::PropertySet expected;
+    for (auto const& name : snapshot->names()) {
+        expected.copy(name, *snapshot, name);
+    }
+    BOOST_CHECK(*snapshot == expected);
+    BOOST_CHECK_EQUAL(snapshot->fingerprint(), expected.fingerprint());
+    snapshot->set("a.b.d", 1);
+    BOOST_CHECK(!cps.exists("a.b.d"));
+}
+
+BOOST_AUTO_TEST_CASE(propertySetsAreCopied) {
+    dafBase::ConcurrentPropertySet cps;
+    auto child = std::make_shared<dafBase::PropertySet>();
+    child->set("x", 1);
+    cps.set("child", child);
+    child->set("x", 2);
+    BOOST_CHECK_EQUAL(cps.get<int>("child.x"), 1);
+
+    auto got = cps.get<std::shared_ptr<dafBase::PropertySet>>("child");
+    got->set("x", 3);
+    BOOST_CHECK_EQUAL(cps.get<int>("child.x"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(concurrentWriters) {
+    int const nThreads = 8;
+    int const nValues = 1000;
+    dafBase::ConcurrentPropertySet cps(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; ++t) {
+        threads.emplace_back([&cps, t, nValues]() {
+            std::string const own = "thread" + std::to_string(t);
+            for (int i = 0; i < nValues; ++i) {
+                // All threads create the same intermediate sets at once
+                cps.add("shared.sub.values", i);
+                cps.set("shared.sub." + own, i);
+                cps.add(own + ".values", i);
+                cps.get<int>("shared.sub.values");
+                cps.names(false);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(cps.getArray<int>("shared.sub.values").size(),
+                      static_cast<std::size_t>(nThreads * nValues));
+    for (int t = 0; t < nThreads; ++t) {
+        std::string const own = "thread" + std::to_string(t);
+        BOOST_CHECK_EQUAL(cps.get<int>("shared.sub." + own), nValues - 1);
+        BOOST_CHECK_EQUAL(cps.getArray<int>(own + ".values").size(), static_cast<std::size_t>(nValues));
+    }
+    BOOST_CHECK_EQUAL(cps.names().size(), static_cast<std::size_t>(nThreads + 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,9 @@
  */
 
 #include "lsst/daf/base/PropertyList.h"
+#include "lsst/daf/base/FrozenPropertySet.h"
+#include "lsst/daf/base/PropertySetPatch.h"
+#include "lsst/daf/base/PropertySetSnapshot.h"
 
 #define BOOST_TEST_MODULE PropertyList
 #define BOOST_TEST_DYN_LINK
@@ -30,9 +33,12 @@
 #pragma clang diagnostic pop
 
 #include <algorithm>
+#include <limits>
 
 #include "lsst/pex/exceptions/Runtime.h"
 
+#include "CountingResource.h"
+
 #define INT64CONST(x) static_cast<int64_t>(x##LL)
 
 namespace test = boost::test_tools;
@@ -451,4 +457,383 @@ BOOST_AUTO_TEST_CASE(combineAsPS) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a
     BOOST_CHECK_EQUAL(newPlp->getComment("float"), "stuff");
 }
 
+BOOST_AUTO_TEST_CASE(precompiledKey) {
+    dafBase::PropertyList pl;
+    pl.set("a.b", 1, "first");
+    pl.set("c", std::string("x"), "second");
+
+    dafBase::PropertyList::Key<int> const ab("a.b");
+    dafBase::PropertyList::Key<int> const d("d");
+    BOOST_CHECK_EQUAL(pl.get(ab), 1);
+    pl.set(ab, 2);
+    pl.set(d, 3);
+    BOOST_CHECK_EQUAL(pl.get<int>("a.b"), 2);
+    BOOST_CHECK_EQUAL(pl.getComment("a.b"), "first");
+    BOOST_CHECK_EQUAL(pl.get(d), 3);
+    std::vector<std::string> const names = pl.getOrderedNames();
+    BOOST_CHECK_EQUAL(names.size(), 3U);
+    BOOST_CHECK_EQUAL(names[0], "a.b");
+    BOOST_CHECK_EQUAL(names[1], "c");
+    BOOST_CHECK_EQUAL(names[2], "d");
+}
+
+BOOST_AUTO_TEST_CASE(deepCopyIsIndependent) {
+    dafBase::PropertyList pl;
+    pl.set("a", 1, "first");
+    pl.set("b", std::vector<int>{1, 2}, "second");
+
+    auto copy = std::static_pointer_cast<dafBase::PropertyList>(pl.deepCopy());
+    pl.set("c", 3, "third");
+    pl.add("b", 3);
+    pl.set("a", 4, "changed");
+    copy->remove("b");
+    BOOST_CHECK_EQUAL(pl.getOrderedNames().size(), 3U);
+    BOOST_CHECK_EQUAL(pl.getArray<int>("b").size(), 3U);
+    BOOST_CHECK_EQUAL(pl.getComment("b"), "second");
+    std::vector<std::string> const names = copy->getOrderedNames();
+    BOOST_CHECK_EQUAL(names.size(), 1U);
+    BOOST_CHECK_EQUAL(names[0], "a");
+    BOOST_CHECK_EQUAL(copy->get<int>("a"), 1);
+    BOOST_CHECK_EQUAL(copy->getComment("a"), "first");
+    BOOST_CHECK(!copy->exists("c"));
+}
+
+BOOST_AUTO_TEST_CASE(moveSemantics) {
+    std::string const longString(100, 'x');
+    dafBase::PropertyList pl;
+    pl.set("a", 1, "first");
+    pl.set("b", std::string(longString), "second");
+    pl.add("b", std::string("c"), std::string("changed"));
+    pl.set("c", std::vector<int>{1, 2}, "third");
+    pl.add("c", std::vector<int>{3});
+
+    dafBase::PropertyList moved(std::move(pl));
+    BOOST_CHECK_EQUAL(moved.getOrderedNames().size(), 3U);
+    BOOST_CHECK_EQUAL(moved.getComment("b"), "changed");
+    BOOST_CHECK_EQUAL(moved.getArray<std::string>("b")[0], longString);
+    BOOST_CHECK_EQUAL(moved.getArray<int>("c").size(), 3U);
+    BOOST_CHECK_EQUAL(pl.getOrderedNames().size(), 0U);
+
+    dafBase::PropertyList source;
+    source.set("c", std::vector<int>{4}, "replaced");
+    source.set("d", std::string(longString), "fourth");
+    moved.combine(std::move(source));
+    std::vector<std::string> const names = moved.getOrderedNames();
+    BOOST_CHECK_EQUAL(names.size(), 4U);
+    BOOST_CHECK_EQUAL(names[3], "d");
+    BOOST_CHECK_EQUAL(moved.getArray<int>("c").size(), 4U);
+    BOOST_CHECK_EQUAL(moved.getComment("c"), "replaced");
+    BOOST_CHECK_EQUAL(moved.get<std::string>("d"), longString);
+    BOOST_CHECK_EQUAL(moved.getComment("d"), "fourth");
+    BOOST_CHECK_EQUAL(source.getOrderedNames().size(), 0U);
+    BOOST_CHECK_EQUAL(source.nameCount(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(setAll) {
+    dafBase::PropertySet::Ptr nested(new dafBase::PropertySet);
+    nested->set("x", 1);
+    dafBase::PropertyList pl;
+    pl.set("int", 1, "kept");
+    pl.set("double", 1.0, "replaced");
+    pl.reserve(10);
+    pl.setAll({{"string", "foo", "a string"},
+               {"int", 42},
+               {"double", 2.0, "new comment"},
+               {"ints", std::vector<int>{1, 2}},
+               {"sub", nested},
+               {"string", "bar"}});
+    std::vector<std::string> const names = pl.getOrderedNames();
+    BOOST_CHECK_EQUAL(names.size(), 5U);
+    BOOST_CHECK_EQUAL(names[0], "int");
+    BOOST_CHECK_EQUAL(names[1], "double");
+    BOOST_CHECK_EQUAL(names[2], "string");
+    BOOST_CHECK_EQUAL(names[3], "ints");
+    BOOST_CHECK_EQUAL(names[4], "sub.x");
+    BOOST_CHECK_EQUAL(pl.get<int>("int"), 42);
+    BOOST_CHECK_EQUAL(pl.getComment("int"), "kept");
+    BOOST_CHECK_EQUAL(pl.getComment("double"), "new comment");
+    BOOST_CHECK_EQUAL(pl.get<std::string>("string"), "bar");
+    BOOST_CHECK_EQUAL(pl.getComment("string"), "a string");
+    BOOST_CHECK_EQUAL(pl.getComment("ints"), "");
+    BOOST_CHECK_EQUAL(pl.get<int>("sub.x"), 1);
+
+    // Through the base class
+    dafBase::PropertyList other;
+    dafBase::PropertySet& ps = other;
+    ps.setAll({{"a", 1, "first"}, {"b", 2}});
+    BOOST_CHECK_EQUAL(other.getOrderedNames().size(), 2U);
+    BOOST_CHECK_EQUAL(other.getComment("a"), "first");
+}
+
+BOOST_AUTO_TEST_CASE(reserveNames) {
+    // Short names, empty comments and scalar numbers are held inline, so only the tables
+    // and the order list, made on the first set, allocate
+    int const n = 300;
+    CountingResource resource;
+    dafBase::PropertyList pl(&resource);
+    pl.reserve(n);
+    pl.set("KEY0", 0);
+    std::size_t const allocations = resource.allocations;
+    BOOST_CHECK_GT(allocations, 0U);
+    for (int i = 1; i < n; ++i) {
+        pl.set("KEY" + std::to_string(i), i);
+    }
+    BOOST_CHECK_EQUAL(pl.getOrderedNames().size(), static_cast<std::size_t>(n));
+    BOOST_CHECK_EQUAL(resource.allocations, allocations);
+
+    // setAll reserves once for all its items
+    std::vector<dafBase::PropertySet::Item> items;
+    for (int i = 0; i < n; ++i) {
+        items.emplace_back("KEY" + std::to_string(i), i);
+    }
+    CountingResource setAllResource;
+    dafBase::PropertyList bulk(&setAllResource);
+    bulk.setAll(std::move(items));
+    BOOST_CHECK_EQUAL(bulk.getOrderedNames().size(), static_cast<std::size_t>(n));
+    BOOST_CHECK_EQUAL(setAllResource.allocations, allocations);
+}
+
+BOOST_AUTO_TEST_CASE(memoryResource) {
+    std::string const longName = "a.name.too.long.to.be.stored.inline";
+    CountingResource resource;
+    {
+        dafBase::PropertyList pl(&resource);
+        BOOST_CHECK_EQUAL(pl.getMemoryResource(), &resource);
+        pl.set("int", 42, "an int");
+        pl.set(longName, std::vector<double>{1.0, 2.0}, "long");
+        pl.add("int", 43);
+        BOOST_CHECK_GT(resource.outstanding, 0U);
+        BOOST_CHECK_EQUAL(pl.getComment(longName), "long");
+
+        auto copy = std::dynamic_pointer_cast<dafBase::PropertyList>(pl.deepCopy());
+        BOOST_CHECK_EQUAL(copy->getMemoryResource(), &resource);
+        copy->set("extra", 1, "added to the copy");
+        BOOST_CHECK_EQUAL(copy->getOrderedNames().back(), "extra");
+        BOOST_CHECK_EQUAL(pl.getOrderedNames().size(), 2U);
+
+        dafBase::PropertyList other;
+        other.set("other", std::vector<int>{1, 2, 3}, "from elsewhere");
+        pl.combine(other);
+        BOOST_CHECK_EQUAL(pl.getArray<int>("other")[2], 3);
+        BOOST_CHECK_EQUAL(pl.getComment("other"), "from elsewhere");
+    }
+    BOOST_CHECK_EQUAL(resource.outstanding, 0U);
+    BOOST_CHECK_EQUAL(resource.mismatches, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(freeze) {
+    dafBase::PropertyList pl;
+    pl.set("ZZZ", 1, "last letter");
+    pl.set("AAA", 2.5, "first letter");
+    pl.set("a.b", std::string("dotted"), "flat name");
+
+    auto frozen = pl.freeze();
+    pl.set("ZZZ", 3, "changed");
+    BOOST_CHECK(frozen->isPropertyList());
+    BOOST_CHECK_EQUAL(frozen->get<int>("ZZZ"), 1);
+    BOOST_CHECK_EQUAL(frozen->get<std::string>("a.b"), "dotted");
+    BOOST_CHECK(!frozen->exists("a"));
+    BOOST_CHECK_EQUAL(frozen->getComment("ZZZ"), "last letter");
+    BOOST_CHECK(frozen->getOrderedNames() == (std::vector<std::string>{"ZZZ", "AAA", "a.b"}));
+
+    auto thawed = std::dynamic_pointer_cast<dafBase::PropertyList>(frozen->thaw());
+    BOOST_REQUIRE(thawed);
+    BOOST_CHECK_EQUAL(thawed->getComment("AAA"), "first letter");
+}
+
+BOOST_AUTO_TEST_CASE(snapshot) {
+    dafBase::PropertyList pl;
+    pl.set("ZZZ", 1, "last letter");
+    pl.set("AAA", 2.5, "first letter");
+
+    auto snap = pl.snapshot();
+    pl.set("ZZZ", 2, "changed");
+    pl.set("BBB", 3);
+    BOOST_CHECK(snap->isPropertyList());
+    BOOST_CHECK_EQUAL(snap->get<int>("ZZZ"), 1);
+    BOOST_CHECK_EQUAL(snap->getComment("ZZZ"), "last letter");
+    BOOST_CHECK_THROW(snap->getComment("BBB"), pexExcept::NotFoundError);
+    BOOST_CHECK(snap->getOrderedNames() == (std::vector<std::string>{"ZZZ", "AAA"}));
+    BOOST_CHECK_EQUAL(pl.getOrderedNames().size(), 3U);
+
+    auto thawed = std::dynamic_pointer_cast<dafBase::PropertyList>(snap->thaw());
+    BOOST_REQUIRE(thawed);
+    thawed->set("CCC", 4, "added");
+    BOOST_CHECK_EQUAL(thawed->getComment("AAA"), "first letter");
+    BOOST_CHECK_EQUAL(snap->nameCount(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(journal) {
+    typedef dafBase::PropertySet::Change::Kind Kind;
+    dafBase::PropertyList pl;
+    pl.setJournaling(true);
+    pl.set("AAA", 1, "comment");
+    pl.add("AAA", 2);
+    pl.remove("AAA");
+    auto journal = pl.takeJournal();
+    BOOST_REQUIRE_EQUAL(journal.size(), 3U);
+    BOOST_CHECK(journal[0].kind == Kind::Set);
+    BOOST_CHECK(journal[1].kind == Kind::Add);
+    BOOST_CHECK(journal[2].kind == Kind::Remove);
+    BOOST_CHECK_EQUAL(journal[2].name, "AAA");
+
+    pl.remove("AAA");
+    pl.remove("missing");
+    BOOST_CHECK(pl.getJournal().empty());
+    BOOST_CHECK_EQUAL(pl.nameCount(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(diff) {
+    typedef dafBase::PropertySetPatch::Edit::Kind Kind;
+    dafBase::PropertyList a;
+    a.set("AAA", 1, "first");
+    a.set("BBB", 2.5, "second");
+    a.set("CCC", std::string("third"), "third");
+    auto b = std::static_pointer_cast<dafBase::PropertyList>(a.deepCopy());
+    b->set("BBB", 2.5, "new comment");
+    b->remove("CCC");
+    b->set("DDD", std::vector<int>{1, 2}, "fourth");
+    auto const patch = dafBase::PropertySetPatch::diff(a, *b);
+    BOOST_REQUIRE_EQUAL(patch.getEdits().size(), 3U);
+    BOOST_CHECK(patch.getEdits()[0].kind == Kind::Remove);
+    BOOST_CHECK(patch.getEdits()[1].kind == Kind::Change);
+    BOOST_CHECK_EQUAL(patch.getEdits()[1].comment, "new comment");
+    BOOST_CHECK(patch.getEdits()[2].kind == Kind::Add);
+    BOOST_CHECK(patch.getOrder().empty());
+
+    auto applied = std::static_pointer_cast<dafBase::PropertyList>(a.deepCopy());
+    applied->apply(dafBase::PropertySetPatch::deserialize(patch.serialize()));
+    BOOST_CHECK(applied->getOrderedNames() == b->getOrderedNames());
+    BOOST_CHECK_EQUAL(applied->getComment("BBB"), "new comment");
+    BOOST_CHECK_EQUAL(applied->getComment("DDD"), "fourth");
+    BOOST_CHECK(applied->getArray<int>("DDD") == (std::vector<int>{1, 2}));
+
+    // A new order that the edits alone would not give is recorded
+    dafBase::PropertyList reordered;
+    reordered.set("BBB", 2.5, "second");
+    reordered.set("AAA", 1, "first");
+    reordered.set("CCC", std::string("third"), "third");
+    auto const reorder = dafBase::PropertySetPatch::diff(a, reordered);
+    BOOST_CHECK(reorder.getEdits().empty());
+    BOOST_CHECK(!reorder.empty());
+    applied = std::static_pointer_cast<dafBase::PropertyList>(a.deepCopy());
+    applied->apply(reorder);
+    BOOST_CHECK(applied->getOrderedNames() == reordered.getOrderedNames());
+
+    // A PropertyList nested in a PropertySet is replaced whole, keeping its order and comments
+    auto list = std::make_shared<dafBase::PropertyList>();
+    list->set("X", 1, "old");
+    dafBase::PropertySet from;
+    from.set("a", std::static_pointer_cast<dafBase::PropertySet>(list));
+    for (int k = 0; k < 2; ++k) {
+        auto toList = std::static_pointer_cast<dafBase::PropertyList>(list->deepCopy());
+        if (k == 0) {
+            toList->set("Y", 2, "added");
+        } else {
+            toList->set("X", 3, "new");
+        }
+        dafBase::PropertySet to;
+        to.set("a", std::static_pointer_cast<dafBase::PropertySet>(toList));
+        auto const nested = dafBase::PropertySetPatch::diff(from, to);
+        BOOST_REQUIRE_EQUAL(nested.getEdits().size(), 1U);
+        BOOST_CHECK_EQUAL(nested.getEdits()[0].name, "a");
+        BOOST_CHECK(nested.getEdits()[0].kind == Kind::Change);
+        auto const nestedApplied = from.deepCopy();
+        nestedApplied->apply(nested);
+        BOOST_CHECK(*nestedApplied == to);
+        auto const appliedList = std::dynamic_pointer_cast<dafBase::PropertyList>(
+                nestedApplied->getAsPropertySetPtr("a"));
+        BOOST_REQUIRE(appliedList);
+        BOOST_CHECK(appliedList->getOrderedNames() == toList->getOrderedNames());
+        BOOST_CHECK_EQUAL(appliedList->getComment("X"), toList->getComment("X"));
+    }
+
+    // Nested PropertyLists survive serialization
+    dafBase::PropertySet to;
+    auto toList = std::make_shared<dafBase::PropertyList>();
+    toList->set("Z", std::string("last"), "set first");
+    toList->set("A", 1.5, "set second");
+    to.set("a", std::static_pointer_cast<dafBase::PropertySet>(toList));
+    to.set("b.c", 1);
+    auto const bytes = dafBase::PropertySetPatch::diff(dafBase::PropertySet(), to).serialize();
+    auto const decoded = dafBase::PropertySetPatch::deserialize(bytes);
+    BOOST_CHECK_EQUAL(decoded.serialize(), bytes);
+    dafBase::PropertySet replayed;
+    replayed.apply(decoded);
+    BOOST_CHECK(replayed == to);
+    auto const replayedList =
+            std::dynamic_pointer_cast<dafBase::PropertyList>(replayed.getAsPropertySetPtr("a"));
+    BOOST_REQUIRE(replayedList);
+    BOOST_CHECK(replayedList->getOrderedNames() == toList->getOrderedNames());
+    BOOST_CHECK_EQUAL(replayedList->getComment("Z"), "set first");
+}
+
+BOOST_AUTO_TEST_CASE(equality) {
+    dafBase::PropertyList a;
+    a.set("AAA", 1, "first");
+    a.set("BBB", std::numeric_limits<double>::quiet_NaN(), "second");
+    auto b = std::static_pointer_cast<dafBase::PropertyList>(a.deepCopy());
+    BOOST_CHECK(a == *b);
+
+    dafBase::PropertyList c;
+    c.set("AAA", 1, "first");
+    c.set("BBB", std::numeric_limits<double>::quiet_NaN(), "second");
+    BOOST_CHECK(a == c);
+    c.set("AAA", 1, "changed");
+    BOOST_CHECK(a != c);
+
+    dafBase::PropertyList reordered;
+    reordered.set("BBB", std::numeric_limits<double>::quiet_NaN(), "second");
+    reordered.set("AAA", 1, "first");
+    BOOST_CHECK(a != reordered);
+
+    // A PropertySet never equals a PropertyList
+    dafBase::PropertySet flat(true);
+    flat.combine(a);
+    BOOST_CHECK(flat != a);
+}
+
+BOOST_AUTO_TEST_CASE(fingerprint) {
+    dafBase::PropertyList a;
+    a.set("AAA", 1, "first");
+    a.set("BBB", 2.0, "second");
+    dafBase::PropertyList reordered;
+    reordered.set("BBB", 2.0, "changed");
+    reordered.set("AAA", 1, "first");
+    BOOST_CHECK_EQUAL(a.fingerprint(), reordered.fingerprint());
+    BOOST_CHECK_EQUAL(a.fingerprint(false, false), reordered.fingerprint(false, false));
+    BOOST_CHECK_NE(a.fingerprint(false, true), reordered.fingerprint(false, true));
+    BOOST_CHECK_NE(a.fingerprint(true, false), reordered.fingerprint(true, false));
+    reordered.set("BBB", 2.0, "second");
+    BOOST_CHECK_EQUAL(a.fingerprint(true, false), reordered.fingerprint(true, false));
+    // The order contributes only when asked for, as in Python
+    BOOST_CHECK_EQUAL(a.fingerprint(true), a.fingerprint(true, false));
+    BOOST_CHECK_EQUAL(a.fingerprint(true), reordered.fingerprint(true));
+    BOOST_CHECK_EQUAL(a.fingerprint(false), a.fingerprint());
+    auto copy = std::static_pointer_cast<dafBase::PropertyList>(a.deepCopy());
+    BOOST_CHECK_EQUAL(a.fingerprint(true, true), copy->fingerprint(true, true));
+}
+
+BOOST_AUTO_TEST_CASE(entries) {
+    dafBase::PropertyList pl;
+    pl.set("ZZZ", 1, "last alphabetically");
+    pl.set("AAA", std::string("x"));
+    pl.add("ZZZ", 2);
+    pl.set("MMM", 3.5);
+
+    std::vector<std::string> names;
+    for (auto const& entry : pl.entries()) {
+        names.emplace_back(entry.getName());
+    }
+    BOOST_CHECK(names == pl.getOrderedNames());
+
+    // Through the base class too
+    dafBase::PropertySet const& ps = pl;
+    auto i = ps.entries().begin();
+    BOOST_CHECK_EQUAL((*i).getName(), "ZZZ");
+    BOOST_CHECK_EQUAL((*i).getArrayView<int>().size(), 2U);
+    BOOST_CHECK_EQUAL((*++i).get<std::string>(), "x");
+    BOOST_CHECK(++++i == ps.entries().end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -825,6 +825,19 @@ class PropertyListTestCase(unittest.TestCase):
                          "v = [ 10, 9, 8 ]\n"
                          )
 
+    def testFingerprint(self):
+        apl = dafBase.PropertyList()
+        apl.set("AAA", 1, "first")
+        apl.set("BBB", 2.0, "second")
+        reordered = dafBase.PropertyList()
+        reordered.set("BBB", 2.0, "second")
+        reordered.set("AAA", 1, "first")
+        # The defaults match C++, so the keys agree across languages
+        self.assertEqual(apl.fingerprint(True), apl.fingerprint(True, False))
+        self.assertEqual(apl.fingerprint(True), reordered.fingerprint(True))
+        self.assertEqual(apl.fingerprint(False), apl.fingerprint())
+        self.assertNotEqual(apl.fingerprint(True, True), reordered.fingerprint(True, True))
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
@@ -21,6 +21,10 @@
  */
 
 #include "lsst/daf/base/PropertySet.h"
+#include "lsst/daf/base/FrozenPropertySet.h"
+#include "lsst/daf/base/PropertySetPatch.h"
+#include "lsst/daf/base/detail/FlatMap.h"
+#include "lsst/daf/base/PropertySetSnapshot.h"
 
 #define BOOST_TEST_MODULE PropertySet_1
 #define BOOST_TEST_DYN_LINK
@@ -30,9 +34,17 @@
 #pragma clang diagnostic pop
 
 #include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <memory_resource>
+#include <sstream>
+#include <thread>
 
 #include "lsst/pex/exceptions/Runtime.h"
 
+#include "CountingResource.h"
+
 #define INT64CONST(x) static_cast<int64_t>(x##LL)
 #define UINT64CONST(x) static_cast<uint64_t>(x##ULL)
 
@@ -206,6 +218,53 @@ BOOST_AUTO_TEST_CASE(getVector) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a Ls
     }
 }
 
+BOOST_AUTO_TEST_CASE(getArrayView) {
+    std::string const longString(100, 'x');
+    dafBase::PropertySet ps;
+    ps.set("ints", std::vector<int>{42, 2008, 1});
+    ps.set("double", 3.5);
+    ps.set("a.bools", std::vector<bool>{true, false});
+    ps.set("short", std::string("short"));
+    ps.set("strings", std::vector<std::string>{"a", longString});
+
+    dafBase::PropertySet::ArrayView<int> ints = ps.getArrayView<int>("ints");
+    BOOST_CHECK_EQUAL(ints.size(), 3U);
+    BOOST_CHECK_EQUAL(ints[1], 2008);
+    BOOST_CHECK_EQUAL(ints.back(), 1);
+    std::vector<int> const expected{42, 2008, 1};
+    BOOST_CHECK_EQUAL_COLLECTIONS(ints.begin(), ints.end(), expected.begin(), expected.end());
+    // Views refer to the stored values
+    BOOST_CHECK_EQUAL(ps.getArrayView<int>("ints").data(), ints.data());
+
+    auto const d = ps.getArrayView<double>("double");
+    BOOST_CHECK_EQUAL(d.size(), 1U);
+    BOOST_CHECK_EQUAL(d.front(), 3.5);
+    auto const bools = ps.getArrayView<bool>("a.bools");
+    BOOST_CHECK_EQUAL(bools.size(), 2U);
+    BOOST_CHECK(bools[0] && !bools[1]);
+
+    auto const shortString = ps.getArrayView<std::string>("short");
+    BOOST_CHECK_EQUAL(shortString.size(), 1U);
+    BOOST_CHECK_EQUAL(shortString[0], "short");
+    auto const strings = ps.getArrayView<std::string>("strings");
+    std::vector<std::string_view> seen(strings.begin(), strings.end());
+    BOOST_CHECK_EQUAL(seen.size(), 2U);
+    BOOST_CHECK_EQUAL(seen[0], "a");
+    BOOST_CHECK_EQUAL(seen[1], longString);
+
+    BOOST_CHECK_THROW(ps.getArrayView<double>("ints"), pexExcept::TypeError);
+    BOOST_CHECK_THROW(ps.getArrayView<int>("missing"), pexExcept::NotFoundError);
+
+    int buffer[4] = {0, 0, 0, 0};
+    BOOST_CHECK_EQUAL(ps.getArrayInto("ints", buffer, 4), 3U);
+    BOOST_CHECK_EQUAL(buffer[2], 1);
+    BOOST_CHECK_EQUAL(buffer[3], 0);
+    BOOST_CHECK_THROW(ps.getArrayInto("ints", buffer, 2), pexExcept::LengthError);
+    std::string stringBuffer[2];
+    BOOST_CHECK_EQUAL(ps.getArrayInto("strings", stringBuffer, 2), 2U);
+    BOOST_CHECK_EQUAL(stringBuffer[1], longString);
+}
+
 BOOST_AUTO_TEST_CASE(addScalar) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a LsstDm-5-25 LsstDm-4-6 "Boost
                                      test harness macros" */
     dafBase::PropertySet ps;
@@ -279,6 +338,329 @@ BOOST_AUTO_TEST_CASE(
     BOOST_CHECK(ps.typeOf("string") == typeid(std::string));
 }
 
+BOOST_AUTO_TEST_CASE(reserve) {
+    dafBase::PropertySet ps;
+    ps.set("ints", 0);
+    ps.reserve("ints", 1000);
+    dafBase::PropertySet::ArrayView<int> const before = ps.getArrayView<int>("ints");
+    for (int i = 1; i < 1000; ++i) {
+        ps.add("ints", i);
+    }
+    // No reallocation within the reserved space
+    BOOST_CHECK_EQUAL(ps.getArrayView<int>("ints").data(), before.data());
+    BOOST_CHECK_EQUAL(ps.valueCount("ints"), 1000U);
+    BOOST_CHECK_EQUAL(ps.get<int>("ints"), 999);
+
+    ps.set("a.b", std::string("x"));
+    ps.reserve("a.b", 0);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("a.b"), "x");
+    ps.reserve("a.b", 10);
+    BOOST_CHECK_EQUAL(ps.valueCount("a.b"), 1U);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("a.b"), "x");
+    BOOST_CHECK_THROW(ps.reserve("missing", 10), pexExcept::NotFoundError);
+}
+
+BOOST_AUTO_TEST_CASE(setAll) {
+    dafBase::PropertySet::Ptr child(new dafBase::PropertySet);
+    child->set("x", 1);
+    dafBase::PropertySet ps;
+    ps.set("int", 1);
+    ps.reserve(100);
+    ps.setAll({{"int", 42},
+               {"double", 3.5, "ignored"},
+               {"string", "foo"},
+               {"ints", std::vector<int>{1, 2, 3}},
+               {"none", std::vector<int>()},
+               {"a.b", std::string("nested")},
+               {"child", child},
+               {"double", 4.5}});
+    BOOST_CHECK_EQUAL(ps.nameCount(), 6U);
+    BOOST_CHECK_EQUAL(ps.get<int>("int"), 42);
+    BOOST_CHECK_EQUAL(ps.valueCount("int"), 1U);
+    BOOST_CHECK_EQUAL(ps.get<double>("double"), 4.5);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("string"), "foo");
+    BOOST_CHECK_EQUAL(ps.valueCount("ints"), 3U);
+    BOOST_CHECK(!ps.exists("none"));
+    BOOST_CHECK_EQUAL(ps.get<std::string>("a.b"), "nested");
+    BOOST_CHECK_EQUAL(ps.getAsPropertySetPtr("child"), child);
+    BOOST_CHECK_EQUAL(ps.get<int>("child.x"), 1);
+
+    BOOST_CHECK_THROW(ps.setAll({{"int.x", 1}}), pexExcept::InvalidParameterError);
+    BOOST_CHECK_THROW(child->setAll({{"loop", child}}), pexExcept::InvalidParameterError);
+}
+
+BOOST_AUTO_TEST_CASE(reserveNames) {
+    // Short names and scalar numbers are held inline, so only the table allocates
+    int const n = 300;
+    CountingResource resource;
+    dafBase::PropertySet ps(&resource);
+    ps.reserve(n);
+    std::size_t const allocations = resource.allocations;
+    BOOST_CHECK_GT(allocations, 0U);
+    for (int i = 0; i < n; ++i) {
+        ps.set("key" + std::to_string(i), i);
+    }
+    BOOST_CHECK_EQUAL(ps.nameCount(), static_cast<std::size_t>(n));
+    BOOST_CHECK_EQUAL(resource.allocations, allocations);
+
+    // setAll reserves once for all its items
+    std::vector<dafBase::PropertySet::Item> items;
+    for (int i = 0; i < n; ++i) {
+        items.emplace_back("key" + std::to_string(i), i);
+    }
+    CountingResource setAllResource;
+    dafBase::PropertySet bulk(&setAllResource);
+    bulk.setAll(std::move(items));
+    BOOST_CHECK_EQUAL(bulk.nameCount(), static_cast<std::size_t>(n));
+    BOOST_CHECK_EQUAL(setAllResource.allocations, allocations);
+}
+
+BOOST_AUTO_TEST_CASE(inlineAndOutOfLine) {
+    // Exercise transitions between values stored inline and out of line
+    dafBase::PropertySet ps;
+    std::string const shortString("14 characters.");
+    std::string const longString("a string that is too long to be stored inline");
+    ps.set("short", shortString);
+    ps.set("long", longString);
+    ps.set("empty", std::string());
+    ps.set("dateTime", dafBase::DateTime(1234567890LL));
+    BOOST_CHECK_EQUAL(ps.get<std::string>("short"), shortString);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("long"), longString);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("empty"), "");
+    BOOST_CHECK_EQUAL(ps.get<dafBase::DateTime>("dateTime").nsecs(), 1234567890LL);
+
+    ps.add("short", longString);
+    ps.add("long", shortString);
+    ps.add("dateTime", dafBase::DateTime(42LL));
+    std::vector<std::string> const expected = {shortString, longString};
+    BOOST_CHECK(ps.getArray<std::string>("short") == expected);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("long"), shortString);
+    BOOST_CHECK_EQUAL(ps.getArray<dafBase::DateTime>("dateTime")[0].nsecs(), 1234567890LL);
+    BOOST_CHECK_EQUAL(ps.get<dafBase::DateTime>("dateTime").nsecs(), 42LL);
+
+    for (int i = 0; i < 100; ++i) {
+        ps.add("ints", i);
+    }
+    ps.add("ints", std::vector<int>{100, 101});
+    std::vector<int> ints = ps.getArray<int>("ints");
+    BOOST_CHECK_EQUAL(ints.size(), 102U);
+    for (int i = 0; i < 102; ++i) {
+        BOOST_CHECK_EQUAL(ints[i], i);
+    }
+
+    ps.set("bools", std::vector<bool>{true, false});
+    ps.add("bools", true);
+    BOOST_CHECK(ps.getArray<bool>("bools") == std::vector<bool>({true, false, true}));
+
+    ps.copy("lastShort", ps, "short", true);
+    BOOST_CHECK_EQUAL(ps.valueCount("lastShort"), 1U);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("lastShort"), longString);
+}
+
+BOOST_AUTO_TEST_CASE(typeTag) {
+    dafBase::PropertySet ps;
+    ps.set("bool", true);
+    ps.set("char", '*');
+    ps.set("int", 2008);
+    ps.set("int64_t", INT64CONST(0xfeeddeadbeef));
+    ps.set("uint64_t", UINT64CONST(0xFFFFFFFFFFFFFFFF));
+    ps.set("double", 2.718281828459045);
+    ps.set("string", std::string("bar"));
+    ps.set("undef", nullptr);
+    ps.set("sub.int", 42);
+    ps.set("dateTime", dafBase::DateTime(0LL));
+
+    using Type = dafBase::PropertySet::Type;
+    BOOST_CHECK(ps.typeTag("bool") == Type::Bool);
+    BOOST_CHECK(ps.typeTag("char") == Type::Char);
+    BOOST_CHECK(ps.typeTag("int") == Type::Int);
+    BOOST_CHECK(ps.typeTag("int64_t") == dafBase::PropertySet::typeTagOfT<int64_t>());
+    BOOST_CHECK(ps.typeTag("uint64_t") == dafBase::PropertySet::typeTagOfT<uint64_t>());
+    BOOST_CHECK(ps.typeTag("double") == Type::Double);
+    BOOST_CHECK(ps.typeTag("string") == Type::String);
+    BOOST_CHECK(ps.typeTag("undef") == Type::Undef);
+    BOOST_CHECK(ps.typeTag("sub") == Type::PropertySet);
+    BOOST_CHECK(ps.typeTag("sub.int") == Type::Int);
+    BOOST_CHECK(ps.typeTag("dateTime") == Type::DateTime);
+    BOOST_CHECK(dafBase::PropertySet::typeTagOfT<dafBase::Persistable::Ptr>() == Type::Persistable);
+    BOOST_CHECK_THROW(ps.typeTag("foo"), pexExcept::NotFoundError);
+}
+
+BOOST_AUTO_TEST_CASE(manyNames) {
+    dafBase::PropertySet ps;
+    int const n = 1000;
+    for (int i = 0; i < n; ++i) {
+        ps.set("name" + std::to_string(i), i);
+    }
+    BOOST_CHECK_EQUAL(ps.nameCount(), static_cast<size_t>(n));
+    // Removing entries shifts later entries of a probe sequence back into the hole
+    for (int i = 0; i < n; i += 2) {
+        ps.remove("name" + std::to_string(i));
+    }
+    BOOST_CHECK_EQUAL(ps.nameCount(), static_cast<size_t>(n / 2));
+    for (int i = 0; i < n; ++i) {
+        std::string const name = "name" + std::to_string(i);
+        if (i % 2 == 0) {
+            BOOST_CHECK(!ps.exists(name));
+        } else {
+            BOOST_CHECK_EQUAL(ps.get<int>(name), i);
+        }
+    }
+    std::vector<std::string> names = ps.names();
+    BOOST_CHECK_EQUAL(names.size(), static_cast<size_t>(n / 2));
+    std::sort(names.begin(), names.end());
+    BOOST_CHECK(std::unique(names.begin(), names.end()) == names.end());
+
+    // Copying within a set must not depend on where the source entry lives
+    for (int i = 1; i < n; i += 2) {
+        ps.copy("name" + std::to_string(i - 1), ps, "name" + std::to_string(i));
+    }
+    for (int i = 0; i < n; ++i) {
+        BOOST_CHECK_EQUAL(ps.get<int>("name" + std::to_string(i)), i | 1);
+    }
+
+    dafBase::PropertySet::Ptr psp = ps.deepCopy();
+    BOOST_CHECK_EQUAL(psp->nameCount(), static_cast<size_t>(n));
+    BOOST_CHECK_EQUAL(psp->get<int>("name998"), 999);
+}
+
+BOOST_AUTO_TEST_CASE(flatMapReserve) {
+    for (std::size_t n : {1U, 6U, 7U, 100U, 192U, 193U, 300U, 1000U}) {
+        lsst::daf::base::detail::FlatMap<int> map;
+        map.reserve(n);
+        std::size_t const capacity = map.capacity();
+        for (std::size_t i = 0; i < n; ++i) {
+            map.try_emplace("name" + std::to_string(i), static_cast<int>(i));
+        }
+        // No rehash within the reserved space
+        BOOST_CHECK_EQUAL(map.size(), n);
+        BOOST_CHECK_EQUAL(map.capacity(), capacity);
+        map.reserve(n);
+        BOOST_CHECK_EQUAL(map.capacity(), capacity);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(stringViewLookup) {
+    dafBase::PropertySet ps;
+    ps.set("a.b.c", 42);
+    ps.add("a.b.c", 2008);
+    ps.set("a.b.d", 3.5);
+    ps.set("top", std::string("value"));
+
+    // Views into a larger buffer, not NUL-terminated at the name
+    std::string const buffer = "a.b.c.d";
+    std::string_view const name = std::string_view(buffer).substr(0, 5);
+    BOOST_CHECK(ps.exists(name));
+    BOOST_CHECK(ps.isArray(name));
+    BOOST_CHECK_EQUAL(ps.valueCount(name), 2U);
+    BOOST_CHECK(ps.typeOf(name) == typeid(int));
+    BOOST_CHECK_EQUAL(ps.get<int>(name), 2008);
+    BOOST_CHECK_EQUAL(ps.getArray<int>(name).size(), 2U);
+    BOOST_CHECK_EQUAL(ps.getAsInt64(name), 2008);
+    BOOST_CHECK_EQUAL(ps.getAsDouble(std::string_view("a.b.d")), 3.5);
+    BOOST_CHECK_EQUAL(ps.getAsString("top"), "value");
+    BOOST_CHECK(!ps.exists(std::string_view(buffer)));
+    BOOST_CHECK(!ps.exists(std::string_view(buffer).substr(0, 4)));
+    BOOST_CHECK(ps.isPropertySetPtr(std::string_view(buffer).substr(0, 3)));
+    BOOST_CHECK_EQUAL(ps.get<int>(std::string_view("a.b.x"), 7), 7);
+    BOOST_CHECK_THROW(ps.get<int>(std::string_view("a.x.c")), pexExcept::NotFoundError);
+    BOOST_CHECK_THROW(ps.get<int>(std::string_view("top.c")), pexExcept::NotFoundError);
+}
+
+BOOST_AUTO_TEST_CASE(precompiledKey) {
+    dafBase::PropertySet ps;
+    ps.set("a.b.c", 42);
+    ps.set("a.b.s", std::string("bar"));
+    ps.set("top", 1.5);
+
+    dafBase::PropertySet::Key<int> const abc("a.b.c");
+    dafBase::PropertySet::Key<double> const top("top");
+    dafBase::PropertySet::Key<std::string> const abs("a.b.s");
+    BOOST_CHECK_EQUAL(abc.getName(), "a.b.c");
+    BOOST_CHECK(abc.getType() == dafBase::PropertySet::Type::Int);
+    BOOST_CHECK_EQUAL(ps.get(abc), 42);
+    BOOST_CHECK_EQUAL(ps.get(top), 1.5);
+    BOOST_CHECK_EQUAL(ps.get(abs), "bar");
+    BOOST_CHECK(ps.exists(dafBase::PropertySet::Path("a.b")));
+    BOOST_CHECK(!ps.exists(dafBase::PropertySet::Path("a.b.x")));
+    BOOST_CHECK(!ps.exists(dafBase::PropertySet::Path("top.x")));
+    BOOST_CHECK_THROW(ps.get(dafBase::PropertySet::Key<int>("a.x.c")), pexExcept::NotFoundError);
+    BOOST_CHECK_THROW(ps.get(dafBase::PropertySet::Key<double>("a.b.c")), pexExcept::TypeError);
+
+    // Replace in place, then with a new type, then create a new hierarchy
+    ps.add("a.b.c", 2008);
+    ps.set(abc, 7);
+    BOOST_CHECK_EQUAL(ps.valueCount("a.b.c"), 1U);
+    BOOST_CHECK_EQUAL(ps.get<int>("a.b.c"), 7);
+    ps.set(dafBase::PropertySet::Key<double>("a.b.c"), 2.5);
+    BOOST_CHECK_EQUAL(ps.get<double>("a.b.c"), 2.5);
+    BOOST_CHECK_THROW(ps.get(abc), pexExcept::TypeError);
+    ps.set(abs, "baz");
+    BOOST_CHECK_EQUAL(ps.get<std::string>("a.b.s"), "baz");
+    dafBase::PropertySet::Key<int> const xyz("x.y.z");
+    ps.set(xyz, 3);
+    BOOST_CHECK_EQUAL(ps.get<int>("x.y.z"), 3);
+
+    // The same key works on a flat set and on a flat set within a hierarchy
+    dafBase::PropertySet::Ptr flat(new dafBase::PropertySet(true));
+    flat->set("a.b.c", 12);
+    BOOST_CHECK_EQUAL(flat->get(abc), 12);
+    dafBase::PropertySet::Ptr nested(new dafBase::PropertySet(true));
+    nested->set("b.c", 13);
+    dafBase::PropertySet outer;
+    outer.set("a", nested);
+    BOOST_CHECK_EQUAL(outer.get(abc), 13);
+    outer.set(abc, 14);
+    BOOST_CHECK_EQUAL(nested->get<int>("b.c"), 14);
+}
+
+BOOST_AUTO_TEST_CASE(nameInterning) {
+    BOOST_CHECK(!dafBase::PropertySet::getNameInterning());
+    dafBase::PropertySet ps1;
+    ps1.set("EXPTIME", 30.0);
+    std::string const longName = "HIERARCH ESO DET CHIP NAME";
+
+    dafBase::PropertySet::setNameInterning(true);
+    dafBase::PropertySet ps2;
+    ps2.set("EXPTIME", 15.0);
+    ps2.set(longName, std::string("chip"));
+    ps2.set("a.b", 1);
+    ps1.set(longName, std::string("other"));
+    dafBase::PropertySet::setNameInterning(false);
+
+    // Owned and interned names behave the same
+    BOOST_CHECK_EQUAL(ps1.get<double>("EXPTIME"), 30.0);
+    BOOST_CHECK_EQUAL(ps2.get<double>("EXPTIME"), 15.0);
+    BOOST_CHECK_EQUAL(ps1.get<std::string>(longName), "other");
+    BOOST_CHECK_EQUAL(ps2.get<std::string>(longName), "chip");
+    BOOST_CHECK_EQUAL(ps2.get<int>("a.b"), 1);
+    ps2.set(longName, std::string("replaced"));
+    BOOST_CHECK_EQUAL(ps2.get<std::string>(longName), "replaced");
+    ps1.combine(ps2);
+    BOOST_CHECK_EQUAL(ps1.valueCount("EXPTIME"), 2U);
+    BOOST_CHECK_EQUAL(ps1.get<int>("a.b"), 1);
+
+    dafBase::PropertySet::Ptr psp = ps2.deepCopy();
+    BOOST_CHECK_EQUAL(psp->get<std::string>(longName), "replaced");
+    ps2.remove(longName);
+    BOOST_CHECK(!ps2.exists(longName));
+    BOOST_CHECK(psp->exists(longName));
+
+    // Interning a name twice yields the same atom
+    using dafBase::detail::Name;
+    Name const a = Name::intern("EXPTIME");
+    Name const b = Name::intern(std::string("EXP") + "TIME");
+    Name const c("EXPTIME");
+    BOOST_CHECK(a.isInterned());
+    BOOST_CHECK(!c.isInterned());
+    BOOST_CHECK_EQUAL(a.getAtom(), b.getAtom());
+    BOOST_CHECK_EQUAL(c.getAtom(), Name::NO_ATOM);
+    BOOST_CHECK(a == b);
+    BOOST_CHECK(a == c);
+    BOOST_CHECK_EQUAL(a.hash(), c.hash());
+    BOOST_CHECK(Name::intern(longName) != a);
+}
+
 BOOST_AUTO_TEST_CASE(arrayProperties) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a LsstDm-5-25 LsstDm-4-6
                                            "Boost test harness macros" */
     dafBase::PropertySet ps;
@@ -402,6 +784,13 @@ BOOST_AUTO_TEST_CASE(names) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a LsstDm
 
     BOOST_CHECK_EQUAL(ps.nameCount(), 4U);
     BOOST_CHECK_EQUAL(ps.nameCount(false), 8U);
+    BOOST_CHECK_EQUAL(ps.valueCount(), 6U);
+    BOOST_CHECK_EQUAL(ps.snapshot()->nameCount(false), 8U);
+    ps.add("ps2.plus", 20.48);
+    ps.set("ps3", std::shared_ptr<dafBase::PropertySet>());
+    BOOST_CHECK_EQUAL(ps.valueCount(), 7U);
+    BOOST_CHECK_EQUAL(ps.nameCount(false), 9U);
+    ps.remove("ps3");
 
     std::vector<std::string> v = ps.names();
     BOOST_CHECK_EQUAL(v.size(), 4U);
@@ -590,6 +979,58 @@ BOOST_AUTO_TEST_CASE(combineThrow) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a
     BOOST_CHECK_THROW(ps.combine(*psp), pexExcept::TypeError);
 }
 
+BOOST_AUTO_TEST_CASE(combineMove) {
+    std::string const longString(100, 'x');
+    dafBase::PropertySet ps;
+    ps.set("int", 42);
+    ps.set("strings", longString);
+    ps.set("ps1.pre", 1);
+
+    dafBase::PropertySet source;
+    source.set("int", 2008);
+    source.set("strings", std::vector<std::string>{longString, "y"});
+    source.set("new", longString);
+    source.set("ps1.pre", 3);
+    source.set("ps2.top", "bottom");
+    dafBase::PropertySet::Ptr sub = source.getAsPropertySetPtr("ps1");
+
+    ps.combine(std::move(source));
+    BOOST_CHECK_EQUAL(ps.valueCount("int"), 2U);
+    std::vector<std::string> strings = ps.getArray<std::string>("strings");
+    BOOST_CHECK_EQUAL(strings.size(), 3U);
+    BOOST_CHECK_EQUAL(strings[1], longString);
+    BOOST_CHECK_EQUAL(strings[2], "y");
+    BOOST_CHECK_EQUAL(ps.get<std::string>("new"), longString);
+    BOOST_CHECK_EQUAL(ps.getArray<int>("ps1.pre").size(), 2U);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("ps2.top"), "bottom");
+    BOOST_CHECK_EQUAL(source.nameCount(), 0U);
+    // Nested sets may have other owners and are left intact
+    BOOST_CHECK_EQUAL(sub->get<int>("pre"), 3);
+
+    // Values that cannot be combined are left in the source intact
+    dafBase::PropertySet bad;
+    bad.set("int", 3.14159);
+    BOOST_CHECK_THROW(ps.combine(std::move(bad)), pexExcept::TypeError);
+    BOOST_CHECK_EQUAL(bad.valueCount("int"), 1U);
+    BOOST_CHECK_EQUAL(bad.get<double>("int"), 3.14159);
+
+    dafBase::PropertySet badArray;
+    badArray.set("fresh", std::vector<int>{1, 2, 3});
+    badArray.set("strings", std::vector<int>{4, 5, 6});
+    BOOST_CHECK_THROW(ps.combine(std::move(badArray)), pexExcept::TypeError);
+    BOOST_CHECK(badArray.getArray<int>("strings") == (std::vector<int>{4, 5, 6}));
+    // "fresh" is combined, and so removed from the source, only if it came first
+    BOOST_CHECK_NE(badArray.exists("fresh"), ps.exists("fresh"));
+    std::vector<int> const fresh = (ps.exists("fresh") ? ps : badArray).getArray<int>("fresh");
+    BOOST_CHECK(fresh == (std::vector<int>{1, 2, 3}));
+    BOOST_CHECK_EQUAL(badArray.fingerprint(), badArray.deepCopy()->fingerprint());
+
+    dafBase::PropertySet badName(true);
+    badName.set("int.sub", longString);
+    BOOST_CHECK_THROW(ps.combine(std::move(badName)), pexExcept::InvalidParameterError);
+    BOOST_CHECK_EQUAL(badName.get<std::string>("int.sub"), longString);
+}
+
 BOOST_AUTO_TEST_CASE(copy) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a LsstDm-5-25 LsstDm-4-6 "Boost test
                                 harness macros" */
     dafBase::PropertySet ps;
@@ -696,6 +1137,259 @@ BOOST_AUTO_TEST_CASE(deepCopy) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a Lss
     BOOST_CHECK_EQUAL(psp2->getAsString("top.bottom"), "x");
 }
 
+BOOST_AUTO_TEST_CASE(deepCopyIsIndependent) {
+    dafBase::PropertySet::Ptr psp(new dafBase::PropertySet);
+    psp->set("int", 42);
+    psp->set("ints", std::vector<int>{1, 2, 3});
+    psp->set("string", std::string("a string too long to be stored inline"));
+    psp->set("a.b.c", 1.5);
+    dafBase::PropertySet::Ptr sub = psp->getAsPropertySetPtr("a");
+
+    // Modify the original in every way after copying
+    dafBase::PropertySet::Ptr copy1 = psp->deepCopy();
+    psp->set("int", 2008);
+    psp->add("ints", 4);
+    psp->remove("string");
+    sub->set("b.c", 2.5);
+    sub->set("d", 7);
+    psp->set(dafBase::PropertySet::Key<int>("int"), 2009);
+    BOOST_CHECK_EQUAL(copy1->get<int>("int"), 42);
+    BOOST_CHECK_EQUAL(copy1->getArray<int>("ints").size(), 3U);
+    BOOST_CHECK_EQUAL(copy1->get<std::string>("string"), "a string too long to be stored inline");
+    BOOST_CHECK_EQUAL(copy1->get<double>("a.b.c"), 1.5);
+    BOOST_CHECK(!copy1->exists("a.d"));
+    BOOST_CHECK(copy1->getAsPropertySetPtr("a") != sub);
+
+    // Modify the copy in every way
+    dafBase::PropertySet::Ptr copy2 = psp->deepCopy();
+    copy2->add("ints", 5);
+    copy2->set("int", 0);
+    copy2->set("a.b.c", 0.0);
+    copy2->getAsPropertySetPtr("a")->remove("d");
+    copy2->copy("x", *psp, "ints");
+    BOOST_CHECK_EQUAL(psp->get<int>("int"), 2009);
+    BOOST_CHECK_EQUAL(psp->getArray<int>("ints").size(), 4U);
+    BOOST_CHECK_EQUAL(copy2->getArray<int>("ints").size(), 5U);
+    BOOST_CHECK_EQUAL(psp->get<double>("a.b.c"), 2.5);
+    BOOST_CHECK_EQUAL(sub->get<int>("d"), 7);
+    BOOST_CHECK_EQUAL(copy2->getArray<int>("x").size(), 4U);
+    psp->add("ints", 6);
+    BOOST_CHECK_EQUAL(copy2->getArray<int>("x").size(), 4U);
+
+    // Copies of copies
+    dafBase::PropertySet::Ptr copy3 = copy2->deepCopy();
+    dafBase::PropertySet::Ptr copy4 = copy3->deepCopy();
+    copy3->set("int", 3);
+    BOOST_CHECK_EQUAL(copy2->get<int>("int"), 0);
+    BOOST_CHECK_EQUAL(copy4->get<int>("int"), 0);
+    copy2.reset();
+    BOOST_CHECK_EQUAL(copy4->getArray<int>("ints").back(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(moveSemantics) {
+    std::string const longString(100, 'x');
+    dafBase::PropertySet ps;
+    ps.set("int", 42);
+    ps.set("a.b", 1.5);
+
+    dafBase::PropertySet moved(std::move(ps));
+    BOOST_CHECK_EQUAL(moved.get<int>("int"), 42);
+    BOOST_CHECK_EQUAL(moved.get<double>("a.b"), 1.5);
+    BOOST_CHECK_EQUAL(ps.nameCount(), 0U);
+    ps.set("int", 1);
+    BOOST_CHECK_EQUAL(ps.get<int>("int"), 1);
+    ps = std::move(moved);
+    BOOST_CHECK_EQUAL(ps.get<int>("int"), 42);
+    BOOST_CHECK(!moved.exists("int"));
+
+    std::string s = longString;
+    ps.set("string", std::move(s));
+    BOOST_CHECK_EQUAL(ps.get<std::string>("string"), longString);
+    s = longString;
+    ps.add("string", std::move(s));
+    ps.add("string", std::string("short"));
+    BOOST_CHECK_EQUAL(ps.valueCount("string"), 3U);
+    BOOST_CHECK_EQUAL(ps.getArray<std::string>("string")[1], longString);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("string"), "short");
+    BOOST_CHECK_THROW(ps.add("int", std::string("x")), pexExcept::TypeError);
+
+    std::vector<std::string> v(3, longString);
+    ps.set("strings", std::move(v));
+    BOOST_CHECK_EQUAL(ps.valueCount("strings"), 3U);
+    v = {longString, "y"};
+    ps.add("strings", std::move(v));
+    BOOST_CHECK_EQUAL(ps.valueCount("strings"), 5U);
+    BOOST_CHECK_EQUAL(ps.get<std::string>("strings"), "y");
+    ps.set("ints", std::vector<int>{1, 2});
+    ps.add("ints", std::vector<int>{3});
+    BOOST_CHECK_EQUAL(ps.getArray<int>("ints")[2], 3);
+    BOOST_CHECK_THROW(ps.add("ints", std::vector<double>{1.0}), pexExcept::TypeError);
+
+    dafBase::PropertySet::Ptr child(new dafBase::PropertySet);
+    ps.set("child", child);
+    BOOST_CHECK_THROW(child->add("loop", std::vector<dafBase::PropertySet::Ptr>{child}),
+                      pexExcept::InvalidParameterError);
+}
+
+BOOST_AUTO_TEST_CASE(memoryResource) {
+    std::string const longName = "a_name_too_long_to_be_stored_inline";
+    std::string const longString(100, 'x');
+    CountingResource resource;
+    {
+        dafBase::PropertySet ps(&resource);
+        BOOST_CHECK_EQUAL(ps.getMemoryResource(), &resource);
+        ps.set("int", 42);
+        ps.set(longName, std::vector<int>{1, 2, 3});
+        for (int i = 0; i < 100; ++i) ps.add("ints", i);
+        ps.set("a.b.c", 1.5);
+        ps.add("a.b.c", 2.5);
+        ps.set("string", longString);
+        BOOST_CHECK_GT(resource.allocations, 0U);
+        BOOST_CHECK_GT(resource.outstanding, 0U);
+
+        // Sets made for hierarchical names allocate from the same resource
+        BOOST_CHECK_EQUAL(ps.getAsPropertySetPtr("a")->getMemoryResource(), &resource);
+        BOOST_CHECK_EQUAL(ps.getAsPropertySetPtr("a.b")->getMemoryResource(), &resource);
+        std::size_t const before = resource.outstanding;
+        ps.set("a.d", std::vector<int>{1, 2, 3});
+        BOOST_CHECK_GT(resource.outstanding, before);
+
+        BOOST_CHECK_EQUAL(ps.getArray<int>(longName)[2], 3);
+        BOOST_CHECK_EQUAL(ps.valueCount("ints"), 100U);
+        BOOST_CHECK_EQUAL(ps.getArray<double>("a.b.c")[0], 1.5);
+
+        auto copy = ps.deepCopy();
+        BOOST_CHECK_EQUAL(copy->getMemoryResource(), &resource);
+        BOOST_CHECK_EQUAL(copy->getAsPropertySetPtr("a.b")->getMemoryResource(), &resource);
+        copy->set("a.b.c", 3.5);
+        BOOST_CHECK_EQUAL(ps.get<double>("a.b.c"), 2.5);
+
+        // Values arriving from a set that uses another allocator are moved or copied in
+        dafBase::PropertySet other;
+        other.set("ints", std::vector<int>{100, 101});
+        other.set("doubles", std::vector<double>{1.0, 2.0, 3.0});
+        other.set("x.y", 5);
+        ps.combine(other);
+        BOOST_CHECK_EQUAL(ps.valueCount("ints"), 102U);
+        BOOST_CHECK_EQUAL(ps.get<int>("x.y"), 5);
+        ps.copy("last", other, "doubles", true);
+        ps.copy("all", other, "doubles");
+        other.set("doubles", 0.0);
+        BOOST_CHECK_EQUAL(ps.getArray<double>("all")[2], 3.0);
+        BOOST_CHECK_EQUAL(ps.get<double>("last"), 3.0);
+        ps.combine(std::move(other));
+        BOOST_CHECK_EQUAL(ps.valueCount("ints"), 104U);
+
+        // Removing a missing name leaves a shared map shared
+        dafBase::PropertySet leaf(&resource);
+        leaf.set("int", 1);
+        auto leafCopy = leaf.deepCopy();
+        std::size_t const allocations = resource.allocations;
+        leafCopy->remove("missing");
+        leafCopy->remove("missing.b");
+        BOOST_CHECK_EQUAL(resource.allocations, allocations);
+
+        // Likewise for the maps of nested sets shared with a deep copy
+        dafBase::PropertySet tree(&resource);
+        tree.set("a.b.c", 1);
+        auto treeCopy = tree.deepCopy();
+        std::size_t const treeAllocations = resource.allocations;
+        treeCopy->remove("a.missing");
+        treeCopy->remove("a.b.missing");
+        treeCopy->remove("a.b.c.d");
+        BOOST_CHECK_EQUAL(resource.allocations, treeAllocations);
+        treeCopy->remove("a.b.c");
+        BOOST_CHECK_GT(resource.allocations, treeAllocations);
+        BOOST_CHECK(tree.exists("a.b.c"));
+        BOOST_CHECK(!treeCopy->exists("a.b.c"));
+
+        // Lookups that may modify a property unshare only the map holding it, and only on a hit
+        auto lookupCopy = tree.deepCopy();
+        std::size_t const lookupAllocations = resource.allocations;
+        BOOST_CHECK_THROW(lookupCopy->reserve("a.b.missing", 10), pexExcept::NotFoundError);
+        BOOST_CHECK_THROW(lookupCopy->reserve("a.b.c.d", 10), pexExcept::NotFoundError);
+        BOOST_CHECK_EQUAL(resource.allocations, lookupAllocations);
+        lookupCopy->add("a.b.c", 2);
+        BOOST_CHECK_GT(resource.allocations, lookupAllocations);
+        BOOST_CHECK_EQUAL(lookupCopy->valueCount("a.b.c"), 2U);
+        BOOST_CHECK_EQUAL(tree.valueCount("a.b.c"), 1U);
+        lookupCopy = tree.deepCopy();
+        lookupCopy->set(dafBase::PropertySet::Key<int>("a.b.c"), 3);
+        BOOST_CHECK_EQUAL(lookupCopy->get<int>("a.b.c"), 3);
+        BOOST_CHECK_EQUAL(tree.get<int>("a.b.c"), 1);
+        leafCopy->remove("int");
+        BOOST_CHECK_GT(resource.allocations, allocations);
+        BOOST_CHECK(leaf.exists("int"));
+
+        dafBase::PropertySet global;
+        global.combine(ps);
+        BOOST_CHECK_EQUAL(global.getMemoryResource(), std::pmr::new_delete_resource());
+        BOOST_CHECK_EQUAL(global.getArray<int>(longName)[1], 2);
+    }
+    BOOST_CHECK_EQUAL(resource.outstanding, 0U);
+    BOOST_CHECK_EQUAL(resource.mismatches, 0U);
+
+    // Values added to a nested set through its parent come from the nested set's resource
+    CountingResource childResource;
+    auto child = std::make_shared<dafBase::PropertySet>(&childResource);
+    child->set("x", std::vector<int>{1, 2, 3});
+    child->set("y", 1.5);
+    CountingResource rootResource;
+    {
+        dafBase::PropertySet root(&rootResource);
+        root.set("child", child);
+        std::size_t const rootAllocations = rootResource.allocations;
+        for (int i = 0; i < 100; ++i) root.add("child.x", i);
+        root.add("child.x", std::vector<int>(100, 7));
+        root.reserve("child.x", 1000);
+        root.set(dafBase::PropertySet::Key<double>("child.y"), 2.5);
+        BOOST_CHECK_EQUAL(rootResource.allocations, rootAllocations);
+    }
+    // The child outlives its parent without holding any of the parent's memory
+    BOOST_CHECK_EQUAL(rootResource.outstanding, 0U);
+    BOOST_CHECK_EQUAL(child->valueCount("x"), 203U);
+    BOOST_CHECK_EQUAL(child->getArray<int>("x")[202], 7);
+    BOOST_CHECK_EQUAL(child->get<double>("y"), 2.5);
+    child.reset();
+    BOOST_CHECK_EQUAL(childResource.outstanding, 0U);
+    BOOST_CHECK_EQUAL(childResource.mismatches, 0U);
+
+    // A pool packs nested maps next to each other, so an entry of one may sit
+    // where another map ends; lookups through nested names must still find it
+    std::pmr::unsynchronized_pool_resource pool;
+    for (int trial = 0; trial < 500; ++trial) {
+        dafBase::PropertySet pooled(&pool);
+        for (int k = 0; k < 5; ++k) {
+            pooled.set("n" + std::to_string(k) + ".x" + std::to_string(trial), k);
+        }
+        for (int k = 0; k < 5; ++k) {
+            std::string const name = "n" + std::to_string(k) + ".x" + std::to_string(trial);
+            BOOST_REQUIRE(pooled.exists(name));
+            BOOST_CHECK(pooled.exists(dafBase::PropertySet::Path(name)));
+            BOOST_CHECK_EQUAL(pooled.get<int>(name), k);
+            BOOST_CHECK_EQUAL(pooled.valueCount(name), 1U);
+            pooled.add(name, k + 1);
+            BOOST_CHECK_EQUAL(pooled.getArray<int>(name)[1], k + 1);
+        }
+        // Sets made for hierarchical names take their storage from the pool too
+        std::string const deep = "d.e" + std::to_string(trial % 7) + ".f";
+        pooled.set(deep, std::to_string(trial));
+        BOOST_CHECK_EQUAL(pooled.getAsPropertySetPtr("n0")->getMemoryResource(), &pool);
+        BOOST_CHECK_EQUAL(pooled.getAsPropertySetPtr("d.e" + std::to_string(trial % 7))->getMemoryResource(),
+                          &pool);
+        BOOST_CHECK_EQUAL(pooled.get(dafBase::PropertySet::Key<std::string>(deep)), std::to_string(trial));
+        BOOST_CHECK(!pooled.exists(deep + ".g"));
+        pooled.remove(deep);
+        BOOST_CHECK(!pooled.exists(deep));
+        BOOST_CHECK(pooled.exists("d"));
+    }
+
+    dafBase::PropertySet ps(std::pmr::new_delete_resource(), true);
+    BOOST_CHECK_EQUAL(ps.getMemoryResource(), std::pmr::new_delete_resource());
+    ps.set("a.b", 1);
+    BOOST_CHECK_EQUAL(ps.nameCount(), 1U);
+}
+
 BOOST_AUTO_TEST_CASE(toString) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a LsstDm-5-25 LsstDm-4-6 "Boost
                                     test harness macros" */
     dafBase::PropertySet ps;
@@ -783,6 +1477,497 @@ BOOST_AUTO_TEST_CASE(cycle) { /* parasoft-suppress LsstDm-3-1 LsstDm-3-4a LsstDm
     BOOST_CHECK_THROW(psp->set("b.c.t", b), pexExcept::InvalidParameterError);
     BOOST_CHECK_THROW(psp->set("b.c.t", c), pexExcept::InvalidParameterError);
     BOOST_CHECK_THROW(a->set("t", psp), pexExcept::InvalidParameterError);
+
+    // Every element of an array of sets is searched, not only the last
+    auto holder = std::make_shared<dafBase::PropertySet>();
+    holder->set("sets", std::vector<std::shared_ptr<dafBase::PropertySet>>{c, nullptr});
+    holder->add("sets", std::make_shared<dafBase::PropertySet>());
+    BOOST_CHECK_THROW(c->set("holder", holder), pexExcept::InvalidParameterError);
+    holder->set("sets", std::vector<std::shared_ptr<dafBase::PropertySet>>{b, nullptr});
+    holder->add("sets", std::make_shared<dafBase::PropertySet>());
+    BOOST_CHECK_THROW(c->set("holder", holder), pexExcept::InvalidParameterError);
+    BOOST_CHECK_NO_THROW(psp->set("holder", holder));
+}
+
+BOOST_AUTO_TEST_CASE(freeze) {
+    dafBase::PropertySet ps;
+    ps.set("int", 42);
+    ps.set("strings", std::vector<std::string>{"a", "b"});
+    ps.set("a.b.c", 1.5);
+    ps.add("a.b.c", 2.5);
+    for (int i = 0; i < 1000; ++i) {
+        ps.set("many.name" + std::to_string(i), i);
+    }
+
+    auto frozen = ps.freeze();
+    ps.set("int", 0);
+    ps.remove("a.b");
+    BOOST_CHECK_EQUAL(frozen->get<int>("int"), 42);
+    BOOST_CHECK_EQUAL(frozen->get<double>("a.b.c"), 2.5);
+    BOOST_CHECK_EQUAL(frozen->getArray<double>("a.b.c")[0], 1.5);
+    BOOST_CHECK_EQUAL(frozen->getArrayView<std::string>("strings")[1], "b");
+    BOOST_CHECK_EQUAL(frozen->get<int>("missing", 7), 7);
+    for (int i = 0; i < 1000; ++i) {
+        BOOST_CHECK_EQUAL(frozen->get<int>("many.name" + std::to_string(i)), i);
+    }
+    BOOST_CHECK(frozen->exists("a"));
+    BOOST_CHECK(frozen->exists("a.b"));
+    BOOST_CHECK(!frozen->exists("a.b.x"));
+    BOOST_CHECK(!frozen->exists("many.name1000"));
+    BOOST_CHECK(frozen->isArray("strings"));
+    BOOST_CHECK(frozen->isPropertySetPtr("a.b"));
+    BOOST_CHECK_EQUAL(frozen->valueCount("a.b.c"), 2U);
+    BOOST_CHECK_EQUAL(frozen->valueCount("missing"), 0U);
+    BOOST_CHECK(frozen->typeOf("int") == typeid(int));
+    BOOST_CHECK_EQUAL(frozen->nameCount(), 4U);
+    BOOST_CHECK_EQUAL(frozen->nameCount(false), 1006U);
+    BOOST_CHECK_EQUAL(frozen->names(false).size(), 1006U);
+    BOOST_CHECK(!frozen->isPropertyList());
+    BOOST_CHECK_THROW(frozen->get<int>("missing"), pexExcept::NotFoundError);
+    BOOST_CHECK_THROW(frozen->get<double>("int"), pexExcept::TypeError);
+    BOOST_CHECK_THROW(frozen->getComment("int"), pexExcept::LogicError);
+
+    // Nested sets are handed out as copies
+    auto ab = frozen->get<dafBase::PropertySet::Ptr>("a.b");
+    ab->set("c", 0.0);
+    BOOST_CHECK_EQUAL(frozen->get<double>("a.b.c"), 2.5);
+
+    BOOST_CHECK_EQUAL(frozen->deepCopy(), frozen);
+    auto thawed = frozen->thaw();
+    thawed->set("int", 1);
+    BOOST_CHECK_EQUAL(thawed->get<double>("a.b.c"), 2.5);
+    BOOST_CHECK_EQUAL(frozen->get<int>("int"), 42);
+
+    auto empty = dafBase::PropertySet().freeze();
+    BOOST_CHECK(!empty->exists("int"));
+    BOOST_CHECK_EQUAL(empty->nameCount(false), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot) {
+    auto ps = std::make_shared<dafBase::PropertySet>();
+    ps->set("int", 1);
+    ps->set("ints", std::vector<int>{1, 2, 3});
+    ps->set("a.b.c", 1.5);
+    ps->set("a.d", std::string("first"));
+    auto ab = ps->getAsPropertySetPtr("a.b");
+
+    auto snap = ps->snapshot();
+    ps->set("int", 2);
+    ps->add("ints", 4);
+    ps->set("a.b.c", 2.5);
+    ab->set("new", 1);
+    ps->remove("a.d");
+    ps->set("x.y", 0);
+    BOOST_CHECK_EQUAL(snap->get<int>("int"), 1);
+    BOOST_CHECK_EQUAL(snap->getArray<int>("ints").size(), 3U);
+    BOOST_CHECK_EQUAL(snap->get<double>("a.b.c"), 1.5);
+    BOOST_CHECK_EQUAL(snap->get<std::string>("a.d"), "first");
+    BOOST_CHECK(!snap->exists("a.b.new"));
+    BOOST_CHECK(!snap->exists("x"));
+    BOOST_CHECK(snap->isArray("ints"));
+    BOOST_CHECK(snap->isPropertySetPtr("a.b"));
+    BOOST_CHECK_EQUAL(snap->valueCount("a.b.c"), 1U);
+    BOOST_CHECK(snap->typeOf("a.d") == typeid(std::string));
+    BOOST_CHECK_EQUAL(snap->nameCount(), 3U);
+    BOOST_CHECK_EQUAL(snap->names(false).size(), 6U);
+    BOOST_CHECK_EQUAL(snap->get<int>("missing", 5), 5);
+    BOOST_CHECK_THROW(snap->get<int>("a.b.x"), pexExcept::NotFoundError);
+    BOOST_CHECK_THROW(snap->get<int>("a.d"), pexExcept::TypeError);
+    BOOST_CHECK_THROW(snap->getOrderedNames(), pexExcept::LogicError);
+
+    auto nested = snap->get<dafBase::PropertySet::Ptr>("a.b");
+    BOOST_CHECK_EQUAL(nested->get<double>("c"), 1.5);
+    BOOST_CHECK(!nested->exists("new"));
+    auto thawed = snap->thaw();
+    thawed->set("a.b.c", 3.5);
+    BOOST_CHECK_EQUAL(snap->get<double>("a.b.c"), 1.5);
+    BOOST_CHECK_EQUAL(ps->get<double>("a.b.c"), 2.5);
+
+    // A reader sees one consistent version while the owner keeps writing
+    auto consistent = ps->snapshot();
+    bool ok = true;
+    std::thread reader([consistent, &ok]() {
+        for (int i = 0; i < 1000; ++i) {
+            ok = ok && consistent->get<int>("int") == 2 && consistent->get<double>("a.b.c") == 2.5 &&
+                 consistent->valueCount("ints") == 4U;
+        }
+    });
+    for (int i = 0; i < 1000; ++i) {
+        ps->set("int", i);
+        ps->add("ints", i);
+        ps->set("a.b.c", static_cast<double>(i));
+    }
+    reader.join();
+    BOOST_CHECK(ok);
+}
+
+BOOST_AUTO_TEST_CASE(journal) {
+    typedef dafBase::PropertySet::Change::Kind Kind;
+    dafBase::PropertySet ps;
+    ps.set("before", 1);
+    BOOST_CHECK(!ps.isJournaling());
+    BOOST_CHECK(ps.getJournal().empty());
+    BOOST_CHECK(ps.takeJournal().empty());
+
+    ps.setJournaling(true);
+    BOOST_CHECK(ps.isJournaling());
+    ps.set("int", 1);
+    ps.add("int", 2);
+    ps.add("a.b", std::string("x"));
+    ps.remove("before");
+    auto const& journal = ps.getJournal();
+    BOOST_REQUIRE_EQUAL(journal.size(), 4U);
+    BOOST_CHECK(journal[0].kind == Kind::Set);
+    BOOST_CHECK_EQUAL(journal[0].name, "int");
+    BOOST_CHECK(journal[1].kind == Kind::Add);
+    BOOST_CHECK_EQUAL(journal[2].name, "a.b");
+    BOOST_CHECK(journal[3].kind == Kind::Remove);
+    BOOST_CHECK_EQUAL(journal[3].name, "before");
+
+    auto taken = ps.takeJournal();
+    BOOST_CHECK_EQUAL(taken.size(), 4U);
+    BOOST_CHECK(ps.isJournaling());
+    BOOST_CHECK(ps.getJournal().empty());
+
+    // copy and combine are recorded as the modifications they make
+    dafBase::PropertySet source;
+    source.set("x", 1.5);
+    source.set("y.z", 2);
+    ps.copy("copied", source, "x");
+    ps.combine(source);
+    taken = ps.takeJournal();
+    BOOST_REQUIRE_EQUAL(taken.size(), 3U);
+    BOOST_CHECK(taken[0].kind == Kind::Set);
+    BOOST_CHECK_EQUAL(taken[0].name, "copied");
+    BOOST_CHECK(taken[1].kind == Kind::Set);
+    BOOST_CHECK(taken[2].kind == Kind::Set);
+    ps.copy("copied", source, "x");
+    taken = ps.takeJournal();
+    BOOST_REQUIRE_EQUAL(taken.size(), 2U);
+    BOOST_CHECK(taken[0].kind == Kind::Remove);
+    BOOST_CHECK(taken[1].kind == Kind::Set);
+
+    // Removing a name that is not there is not a modification
+    ps.remove("missing");
+    ps.remove("a.missing");
+    ps.remove("missing.b");
+    BOOST_CHECK(ps.getJournal().empty());
+    ps.remove("a.b");
+    BOOST_REQUIRE_EQUAL(ps.getJournal().size(), 1U);
+    BOOST_CHECK_EQUAL(ps.getJournal()[0].name, "a.b");
+    ps.takeJournal();
+
+    ps.setAll({{"p", 1}});
+    BOOST_REQUIRE_EQUAL(ps.getJournal().size(), 1U);
+    BOOST_CHECK_EQUAL(ps.getJournal()[0].name, "p");
+
+    // Changes made to a nested PropertySet directly belong to its own journal
+    ps.takeJournal();
+    ps.getAsPropertySetPtr("a")->set("c", 3);
+    BOOST_CHECK(ps.getJournal().empty());
+    BOOST_CHECK(!ps.deepCopy()->isJournaling());
+
+    ps.setJournaling(false);
+    ps.set("int", 5);
+    BOOST_CHECK(ps.getJournal().empty());
+}
+
+BOOST_AUTO_TEST_CASE(diff) {
+    typedef dafBase::PropertySetPatch::Edit::Kind Kind;
+    dafBase::PropertySet a;
+    a.set("same", 1);
+    a.set("nan", std::numeric_limits<double>::quiet_NaN());
+    a.set("ints", std::vector<int>{1, 2, 3});
+    a.set("gone", std::string("x"));
+    a.set("sub.same", 2.5);
+    a.set("sub.changed", 1);
+    a.set("sub.deep.gone", true);
+    a.set("scalar", 1);
+    auto b = a.deepCopy();
+    BOOST_CHECK(dafBase::PropertySetPatch::diff(a, *b).empty());
+
+    b->set("ints", std::vector<int>{1, 2, 4});
+    b->remove("gone");
+    b->set("sub.changed", 2);
+    b->remove("sub.deep");
+    b->set("sub.added", std::string("new"));
+    b->remove("scalar");
+    b->set("scalar.now.a.set", 1L);
+    b->set("date", dafBase::DateTime(12345LL, dafBase::DateTime::TAI));
+    auto const patch = dafBase::PropertySetPatch::diff(a, *b);
+    BOOST_CHECK_EQUAL(patch.getEdits().size(), 7U);
+    std::map<std::string, Kind> kinds;
+    for (auto const& edit : patch.getEdits()) {
+        kinds[edit.name] = edit.kind;
+    }
+    BOOST_CHECK(kinds["ints"] == Kind::Change);
+    BOOST_CHECK(kinds["gone"] == Kind::Remove);
+    BOOST_CHECK(kinds["sub.changed"] == Kind::Change);
+    BOOST_CHECK(kinds["sub.deep"] == Kind::Remove);
+    BOOST_CHECK(kinds["sub.added"] == Kind::Add);
+    BOOST_CHECK(kinds["scalar"] == Kind::Change);
+    BOOST_CHECK(kinds["date"] == Kind::Add);
+    // Removals come first, including those within nested sets
+    BOOST_CHECK(patch.getEdits()[0].kind == Kind::Remove);
+    BOOST_CHECK(patch.getEdits()[1].kind == Kind::Remove);
+    BOOST_CHECK(patch.getValues().getArray<int>("ints") == (std::vector<int>{1, 2, 4}));
+    BOOST_CHECK(patch.getValues().getAsPropertySetPtr("scalar")->exists("now.a.set"));
+
+    // The patch holds copies, not the sets of its source
+    b->set("scalar.now.a.set", 2L);
+    BOOST_CHECK_EQUAL(patch.getValues().getAsPropertySetPtr("scalar")->get<long>("now.a.set"), 1L);
+    b->set("scalar.now.a.set", 1L);
+
+    auto applied = a.deepCopy();
+    applied->apply(patch);
+    BOOST_CHECK(dafBase::PropertySetPatch::diff(*applied, *b).empty());
+    BOOST_CHECK_EQUAL(applied->get<int>("sub.changed"), 2);
+    BOOST_CHECK(!applied->exists("sub.deep"));
+    BOOST_CHECK(!applied->exists("gone"));
+
+    // Serialized patches replay the same way
+    std::string const bytes = patch.serialize();
+    auto const decoded = dafBase::PropertySetPatch::deserialize(bytes);
+    BOOST_CHECK_EQUAL(decoded.serialize(), bytes);
+    auto replayed = a.deepCopy();
+    replayed->apply(decoded);
+    BOOST_CHECK(dafBase::PropertySetPatch::diff(*replayed, *b).empty());
+    BOOST_CHECK_EQUAL(replayed->get<dafBase::DateTime>("date").nsecs(), 12345LL);
+    BOOST_CHECK_THROW(dafBase::PropertySetPatch::deserialize(bytes.substr(0, bytes.size() - 1)),
+                      pexExcept::InvalidParameterError);
+    BOOST_CHECK_THROW(dafBase::PropertySetPatch::deserialize("junk"), pexExcept::InvalidParameterError);
+
+    dafBase::PropertySet withPersistable;
+    withPersistable.set("p", std::make_shared<dafBase::Persistable>());
+    BOOST_CHECK_THROW(dafBase::PropertySetPatch::diff(a, withPersistable).serialize(), pexExcept::TypeError);
+}
+
+BOOST_AUTO_TEST_CASE(equality) {
+    dafBase::PropertySet a;
+    a.set("int", 1);
+    a.set("nan", std::numeric_limits<double>::quiet_NaN());
+    a.set("floats", std::vector<float>{1.0f, std::numeric_limits<float>::quiet_NaN()});
+    a.set("sub.string", std::string("x"));
+    a.set("sub.deeper.value", 2L);
+    auto b = a.deepCopy();
+    BOOST_CHECK(a == a);
+    BOOST_CHECK(a == *b);
+    BOOST_CHECK(!(a != *b));
+
+    // Equal contents built separately, so that no storage is shared
+    dafBase::PropertySet c;
+    c.set("sub.deeper.value", 2L);
+    c.set("sub.string", std::string("x"));
+    c.add("floats", 1.0f);
+    c.add("floats", std::numeric_limits<float>::quiet_NaN());
+    c.set("nan", std::numeric_limits<double>::quiet_NaN());
+    c.set("int", 1);
+    BOOST_CHECK(a == c);
+
+    b->set("sub.deeper.value", 3L);
+    BOOST_CHECK(a != *b);
+    b = a.deepCopy();
+    b->set("int", 1L);  // Same value, different type
+    BOOST_CHECK(a != *b);
+    b = a.deepCopy();
+    b->add("floats", 2.0f);
+    BOOST_CHECK(a != *b);
+    b = a.deepCopy();
+    b->set("extra", true);
+    BOOST_CHECK(a != *b);
+    b->remove("extra");
+    BOOST_CHECK(a == *b);
+}
+
+BOOST_AUTO_TEST_CASE(fingerprint) {
+    dafBase::PropertySet a;
+    BOOST_CHECK_EQUAL(a.fingerprint(), dafBase::PropertySet().fingerprint());
+    a.set("int", 1);
+    a.set("zero", 0.0);
+    a.set("nan", std::numeric_limits<double>::quiet_NaN());
+    a.set("strings", std::vector<std::string>{"x", "y"});
+    a.set("sub.value", 2L);
+
+    // Independent of the order of insertion and of how arrays were built
+    dafBase::PropertySet b;
+    b.set("sub.value", 2L);
+    b.add("strings", std::string("x"));
+    b.add("strings", std::string("y"));
+    b.set("nan", -std::numeric_limits<double>::quiet_NaN());
+    b.set("zero", -0.0);
+    b.set("int", 1);
+    BOOST_CHECK(a == b);
+    BOOST_CHECK_EQUAL(a.fingerprint(), b.fingerprint());
+    BOOST_CHECK_EQUAL(a.fingerprint(), a.deepCopy()->fingerprint());
+    BOOST_CHECK_EQUAL(a.fingerprint(), a.snapshot()->thaw()->fingerprint());
+
+    // Sensitive to names, types, values and their order within an array
+    std::uint64_t const original = a.fingerprint();
+    b.set("int", 1L);
+    BOOST_CHECK_NE(b.fingerprint(), original);
+    b.set("int", 2);
+    BOOST_CHECK_NE(b.fingerprint(), original);
+    b.set("int", 1);
+    BOOST_CHECK_EQUAL(b.fingerprint(), original);
+    b.set("strings", std::vector<std::string>{"y", "x"});
+    BOOST_CHECK_NE(b.fingerprint(), original);
+    b.set("strings", std::vector<std::string>{"x", "y"});
+    b.set("extra", true);
+    BOOST_CHECK_NE(b.fingerprint(), original);
+    b.remove("extra");
+    BOOST_CHECK_EQUAL(b.fingerprint(), original);
+
+    // Modifications to nested sets, even through other pointers, are seen
+    a.getAsPropertySetPtr("sub")->set("value", 3L);
+    BOOST_CHECK_NE(a.fingerprint(), original);
+    a.set("sub.value", 2L);
+    BOOST_CHECK_EQUAL(a.fingerprint(), original);
+    a.remove("sub.value");
+    BOOST_CHECK_NE(a.fingerprint(), original);
+
+    // Fingerprints are persistent cache keys, so must not change between
+    // releases or platforms
+    dafBase::PropertySet fixed;
+    fixed.set("answer", 42);
+    fixed.set("name", std::string("value"));
+    BOOST_CHECK_EQUAL(fixed.fingerprint(), UINT64CONST(0x9CB2D4A9D11FDB39));
+}
+
+BOOST_AUTO_TEST_CASE(entries) {
+    dafBase::PropertySet ps;
+    ps.set("int", 42);
+    ps.set("strings", std::vector<std::string>{"a", "b"});
+    ps.set("a.b.c", 1.5);
+    ps.add("a.b.c", 2.5);
+    ps.set("a.d", true);
+    ps.set("empty", std::make_shared<dafBase::PropertySet>());
+    ps.set("null", std::shared_ptr<dafBase::PropertySet>());
+
+    for (bool topLevelOnly : {true, false}) {
+        std::vector<std::string> names;
+        std::size_t values = 0;
+        for (auto const& entry : ps.entries(topLevelOnly)) {
+            names.emplace_back(entry.getName());
+            BOOST_CHECK(entry.getType() == ps.typeTag(entry.getName()));
+            BOOST_CHECK_EQUAL(entry.size(), ps.valueCount(entry.getName()));
+            if (entry.getType() != dafBase::PropertySet::Type::PropertySet) {
+                values += entry.size();
+            }
+        }
+        BOOST_CHECK(names == ps.names(topLevelOnly));
+        if (!topLevelOnly) {
+            BOOST_CHECK_EQUAL(values, ps.valueCount());
+        }
+    }
+
+    for (auto const& entry : ps.entries(false)) {
+        if (entry.getName() == "a.b.c") {
+            BOOST_CHECK(entry.isArray());
+            BOOST_CHECK_EQUAL(entry.get<double>(), 2.5);
+            BOOST_CHECK_EQUAL(entry.getArrayView<double>()[0], 1.5);
+            BOOST_CHECK_THROW(entry.get<float>(), pexExcept::TypeError);
+        } else if (entry.getName() == "strings") {
+            BOOST_CHECK_EQUAL(entry.getArrayView<std::string>().front(), "a");
+        }
+    }
+
+    dafBase::PropertySet const empty;
+    BOOST_CHECK(empty.entries(false).begin() == empty.entries(false).end());
+}
+
+BOOST_AUTO_TEST_CASE(visit) {
+    dafBase::PropertySet ps;
+    ps.set("ints", std::vector<int>{1, 2, 3});
+    ps.set("string", std::string("a rather long string value"));
+    ps.set("sub.double", 0.5);
+    ps.add("sub.double", 1.5);
+
+    auto const sum = [](auto const& values) -> double {
+        typedef typename std::decay_t<decltype(values)>::value_type T;
+        double result = 0.0;
+        if constexpr (std::is_arithmetic<T>::value) {
+            for (auto const& v : values) {
+                result += v;
+            }
+        }
+        return result;
+    };
+    BOOST_CHECK_EQUAL(ps.visit("ints", sum), 6.0);
+    BOOST_CHECK_EQUAL(ps.visit("sub.double", sum), 2.0);
+    BOOST_CHECK_EQUAL(ps.visit("string", sum), 0.0);
+    BOOST_CHECK_THROW(ps.visit("missing", sum), pexExcept::NotFoundError);
+
+    std::size_t length = 0;
+    ps.visit("string", [&length](auto const& values) {
+        if constexpr (std::is_same<std::decay_t<decltype(values)>,
+                                   dafBase::PropertySet::ArrayView<std::string>>::value) {
+            length = values.front().size();
+        }
+    });
+    BOOST_CHECK_EQUAL(length, 26U);
+
+    std::map<std::string, std::size_t> counts;
+    ps.visitAll([&counts](std::string_view name, auto const& values) {
+        counts[std::string(name)] = values.size();
+    }, false);
+    std::map<std::string, std::size_t> const expected = {
+            {"ints", 3}, {"string", 1}, {"sub", 1}, {"sub.double", 2}};
+    BOOST_CHECK(counts == expected);
+}
+
+BOOST_AUTO_TEST_CASE(formatNumbers) {
+    // Numbers are formatted as by printf("%#.7g") for float and "%#.14g" for double
+    std::vector<double> const values = {0.0,        -0.0,      1.0,       0.5,        1e-5,
+                                        1.5e-4,     123456.0,  1234567.0, 9999999.5,  12345678.0,
+                                        1e100,      -2.5e-300, 1.0 / 3.0, 99999999999999.0, 1e14,
+                                        std::numeric_limits<double>::infinity()};
+    for (double v : values) {
+        dafBase::PropertySet ps;
+        ps.set("f", static_cast<float>(v));
+        ps.set("d", v);
+        char expected[128];
+        std::snprintf(expected, sizeof(expected), "d = %#.14g\nf = %#.7g\n", v,
+                      static_cast<double>(static_cast<float>(v)));
+        BOOST_CHECK_EQUAL(ps.toString(), expected);
+    }
+
+    dafBase::PropertySet ps;
+    ps.set("ints", std::vector<long long>{std::numeric_limits<long long>::min(), 0, -1});
+    ps.set("uchar", static_cast<unsigned char>('x'));
+    std::ostringstream os;
+    os << ps;
+    BOOST_CHECK_EQUAL(os.str(), "ints = [ -9223372036854775808, 0, -1 ]\nuchar = 'x'\n\n");
+}
+
+BOOST_AUTO_TEST_CASE(tryGet) {
+    dafBase::PropertySet ps;
+    ps.set("int", std::vector<int>{1, 2, 3});
+    ps.set("sub.double", 3.5);
+    ps.set("undef", nullptr);
+
+    BOOST_CHECK(!ps.tryGet<int>("missing"));
+    BOOST_CHECK(!ps.tryGet<int>("sub.missing"));
+    BOOST_CHECK(!ps.tryGet<int>("int.deeper"));
+    BOOST_CHECK(!ps.tryGet<long>("int"));
+    BOOST_CHECK(!ps.tryGet<double>("sub"));
+    BOOST_CHECK_EQUAL(ps.tryGet<int>("int").value(), 3);
+    BOOST_CHECK_EQUAL(ps.tryGet<double>("sub.double").value(), 3.5);
+    BOOST_CHECK(ps.tryGet<dafBase::PropertySet::Ptr>("sub").value() == ps.getAsPropertySetPtr("sub"));
+    BOOST_CHECK(ps.tryGet<std::nullptr_t>("undef").has_value());
+
+    BOOST_CHECK(!ps.tryGetArray<int>("missing"));
+    BOOST_CHECK(!ps.tryGetArray<float>("int"));
+    BOOST_CHECK(ps.tryGetArray<int>("int").value() == (std::vector<int>{1, 2, 3}));
+
+    BOOST_CHECK(!ps.tryTypeTag("missing"));
+    BOOST_CHECK(ps.tryTypeTag("int") == dafBase::PropertySet::Type::Int);
+    BOOST_CHECK(ps.tryTypeTag("sub") == dafBase::PropertySet::Type::PropertySet);
+    BOOST_CHECK(ps.tryTypeTag("sub.double") == dafBase::PropertySet::Type::Double);
+
+    BOOST_CHECK(ps.tryTypeOf("missing") == nullptr);
+    BOOST_CHECK(ps.tryTypeOf("sub.missing") == nullptr);
+    BOOST_CHECK(*ps.tryTypeOf("int") == ps.typeOf("int"));
+    BOOST_CHECK(*ps.tryTypeOf("sub.double") == typeid(double));
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
 #
 
 import dataclasses
+import math
 import pickle
 import unittest
 
@@ -332,6 +333,49 @@ class PropertySetTestCase(unittest.TestCase):
         self.assertEqual(source.valueCount(), 5)
         self.assertEqual(dest.valueCount(), 6)
 
+    def testEquality(self):
+        ps = dafBase.PropertySet()
+        ps.set("int", 42)
+        ps.set("nan", math.nan)
+        ps.set("top.bottom", "x")
+        copy = ps.deepCopy()
+        self.assertEqual(ps, copy)
+        copy.set("top.bottom", "y")
+        self.assertNotEqual(ps, copy)
+        copy = ps.deepCopy()
+        copy.setLongLong("int", 42)
+        self.assertNotEqual(ps, copy)
+        self.assertNotEqual(ps, dafBase.PropertyList())
+        self.assertNotEqual(ps, {"int": 42})
+
+    def testFingerprint(self):
+        ps = dafBase.PropertySet()
+        ps.set("int", 42)
+        ps.set("top.bottom", "x")
+        other = dafBase.PropertySet()
+        other.set("top.bottom", "x")
+        other.set("int", 42)
+        self.assertEqual(ps.fingerprint(), other.fingerprint())
+        other.set("top.bottom", "y")
+        self.assertNotEqual(ps.fingerprint(), other.fingerprint())
+
+    def testNameInterning(self):
+        self.assertFalse(dafBase.PropertySet.getNameInterning())
+        ps = dafBase.PropertySet()
+        ps.set("owned", 1)
+        dafBase.PropertySet.setNameInterning(True)
+        try:
+            self.assertTrue(dafBase.PropertySet.getNameInterning())
+            ps.set("interned", 2)
+            ps.set("top.bottom", "x")
+        finally:
+            dafBase.PropertySet.setNameInterning(False)
+        self.assertEqual(set(ps.names(False)), {"owned", "interned", "top", "top.bottom"})
+        self.assertEqual(ps.getAsInt("interned"), 2)
+        self.assertEqual(ps.getAsString("top.bottom"), "x")
+        ps.remove("interned")
+        self.assertFalse(ps.exists("interned"))
+
 
 class FlatTestCase(unittest.TestCase):
     """A test case for flattened PropertySets.